@@ -0,0 +1,53 @@
+#ifndef BIT_ROW_H
+#define BIT_ROW_H
+
+#include <cstdint>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Операции над строкой битов, упакованной в слова по 64 бита (бит x - в слове x / 64)
+
+inline int countTrailingZeros(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+inline int popCount(uint64_t value) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(value);
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+// Биты [begin, end) слова word
+inline uint64_t wordMask(int word, int begin, int end) {
+    int lo = std::max(begin - word * 64, 0);
+    int hi = std::min(end - word * 64, 64);
+    if (lo >= hi) {
+        return 0;
+    }
+    uint64_t high = hi == 64 ? ~0ull : (1ull << hi) - 1;
+    return high & ~((1ull << lo) - 1);
+}
+
+// Позиция первого бита со значением value в [from, end); end, если такого нет
+inline int findNext(const uint64_t* bits, int from, int end, bool value) {
+    int words = (end + 63) / 64;
+    for (int word = from / 64; word < words; word++) {
+        uint64_t w = (value ? bits[word] : ~bits[word]) & wordMask(word, from, end);
+        if (w) {
+            return word * 64 + countTrailingZeros(w);
+        }
+    }
+    return end;
+}
+
+#endif
@@ -0,0 +1,80 @@
+#include "CollisionGrid.h"
+#include <algorithm>
+#include <cmath>
+
+CollisionGrid::CollisionGrid() : originX(0.0f), originZ(0.0f), cellSize(1.0f), cols(0), rows(0) {}
+
+void CollisionGrid::clear() {
+    cols = 0;
+    rows = 0;
+    cellStart.clear();
+    cellBoxes.clear();
+}
+
+void CollisionGrid::build(const std::vector<float>& walls, float mapWidth, float mapHeight) {
+    clear();
+    size_t boxCount = walls.size() / 4;
+    if (boxCount == 0) {
+        return;
+    }
+
+    // Границы сетки: карта плюс стены, выходящие за неё (WAD-стены могут торчать за край)
+    float minX = -mapWidth / 2, maxX = mapWidth / 2;
+    float minZ = -mapHeight / 2, maxZ = mapHeight / 2;
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        minX = std::min(minX, walls[i]);
+        minZ = std::min(minZ, walls[i + 1]);
+        maxX = std::max(maxX, walls[i] + walls[i + 2]);
+        maxZ = std::max(maxZ, walls[i + 1] + walls[i + 3]);
+    }
+
+    // В среднем около одного бокса на ячейку
+    cellSize = std::sqrt((maxX - minX) * (maxZ - minZ) / boxCount);
+    cellSize = std::max(0.25f, std::min(cellSize, 2.0f));
+    originX = minX;
+    originZ = minZ;
+    cols = (int)std::floor((maxX - minX) / cellSize) + 1;
+    rows = (int)std::floor((maxZ - minZ) / cellSize) + 1;
+
+    // Сортировка подсчётом: сначала размеры ячеек, затем раскладка номеров боксов
+    cellStart.assign(cols * rows + 1, 0);
+    auto forEachCell = [&](size_t i, auto&& action) {
+        int col1 = cellCol(walls[i] + walls[i + 2]);
+        int row1 = cellRow(walls[i + 1] + walls[i + 3]);
+        for (int row = cellRow(walls[i + 1]); row <= row1; row++) {
+            for (int col = cellCol(walls[i]); col <= col1; col++) {
+                action(row * cols + col);
+            }
+        }
+    };
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        forEachCell(i, [&](int cell) { cellStart[cell + 1]++; });
+    }
+    for (int cell = 0; cell < cols * rows; cell++) {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+    cellBoxes.resize(cellStart[cols * rows]);
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        forEachCell(i, [&](int cell) { cellBoxes[fill[cell]++] = (int)(i / 4); });
+    }
+}
+
+int CollisionGrid::cellCol(float x) const {
+    return std::max(0, std::min(cols - 1, (int)std::floor((x - originX) / cellSize)));
+}
+
+int CollisionGrid::cellRow(float z) const {
+    return std::max(0, std::min(rows - 1, (int)std::floor((z - originZ) / cellSize)));
+}
+
+void CollisionGrid::collect(float minX, float minZ, float maxX, float maxZ, std::vector<int>& boxes) const {
+    if (cols == 0) {
+        return;
+    }
+    int col0 = cellCol(minX), col1 = cellCol(maxX);
+    int row0 = cellRow(minZ), row1 = cellRow(maxZ);
+    for (int row = row0; row <= row1; row++) {
+        boxes.insert(boxes.end(), cellBoxes.begin() + cellStart[row * cols + col0], cellBoxes.begin() + cellStart[row * cols + col1 + 1]);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef COLLISION_GRID_H
+#define COLLISION_GRID_H
+
+#include <vector>
+
+// Равномерная сетка для грубой фазы коллизий: в каждой ячейке - номера боксов стен (x, z, w, h),
+// которые её задевают. Хранится сжато: cellStart[c]..cellStart[c + 1] - диапазон в cellBoxes
+class CollisionGrid {
+public:
+    CollisionGrid();
+    void build(const std::vector<float>& walls, float mapWidth, float mapHeight);
+    void clear();
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    float getCellSize() const { return cellSize; }
+
+    // Вызывает visitor(номер бокса) для боксов из ячеек, задевающих прямоугольник.
+    // Бокс, лежащий в нескольких ячейках, может прийти несколько раз.
+    // Если visitor вернул true, обход прерывается и возвращается true
+    template <typename Visitor>
+    bool visit(float minX, float minZ, float maxX, float maxZ, Visitor visitor) const {
+        if (cols == 0) {
+            return false;
+        }
+        int col0 = cellCol(minX), col1 = cellCol(maxX);
+        int row0 = cellRow(minZ), row1 = cellRow(maxZ);
+        for (int row = row0; row <= row1; row++) {
+            for (int col = col0; col <= col1; col++) {
+                int cell = row * cols + col;
+                for (int i = cellStart[cell]; i < cellStart[cell + 1]; i++) {
+                    if (visitor(cellBoxes[i])) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // Дописывает в boxes номера боксов из ячеек, задевающих прямоугольник (с повторами).
+    // Ячейки одной строки сетки лежат в cellBoxes подряд - копируется по диапазону на строку
+    void collect(float minX, float minZ, float maxX, float maxZ, std::vector<int>& boxes) const;
+
+private:
+    friend class LevelCache;
+
+    int cellCol(float x) const;
+    int cellRow(float z) const;
+
+    float originX, originZ;
+    float cellSize;
+    int cols, rows;
+    std::vector<int> cellStart;
+    std::vector<int> cellBoxes;
+};
+
+#endif
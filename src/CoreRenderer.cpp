@@ -0,0 +1,518 @@
+#include "CoreRenderer.h"
+#include "Renderer.h"
+#include "Maze.h"
+#include "Player.h"
+#include "GLExtensions.h"
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <string>
+
+ShaderProgram CoreRenderer::meshProgram;
+ShaderProgram CoreRenderer::wallProgram;
+ShaderProgram CoreRenderer::shadowProgram;
+GLuint CoreRenderer::meshArray = 0;
+GLuint CoreRenderer::wallArray = 0;
+GLuint CoreRenderer::shadowArray = 0;
+GLuint CoreRenderer::meshBuffer = 0;
+GLuint CoreRenderer::frameUniforms = 0;
+GLuint CoreRenderer::materialUniforms = 0;
+GLsizeiptr CoreRenderer::materialStride = 0;
+GLuint CoreRenderer::materialTextures[MATERIAL_COUNT] = {};
+GLint CoreRenderer::floorFirst = 0;
+GLint CoreRenderer::shadowQuadFirst = 0;
+GLint CoreRenderer::exitFirst = 0;
+std::vector<CoreRenderer::DrawCommand> CoreRenderer::queue;
+
+namespace {
+
+// Точки привязки uniform-буферов
+const GLuint frameBinding = 0;
+const GLuint materialBinding = 1;
+
+// Номера атрибутов вершин
+const GLuint positionAttribute = 0;
+const GLuint normalAttribute = 1;
+const GLuint texCoordAttribute = 2;
+const GLuint wallAttribute = 3;
+
+// Раскладка std140 блоков Frame и Material. Свет - в системе камеры; fogRange - начало, конец
+// и 1 / (конец - начало) тумана по глубине; lightmapPlane переводит мировые (x, z) пола в координаты
+// карты освещения: xz * plane.xy + plane.zw. Флаги материала: текстура, освещение, карта освещения
+struct FrameBlock {
+    GLfloat projection[16];
+    GLfloat view[16];
+    GLfloat lightPosition[4];
+    GLfloat lightDiffuse[4];
+    GLfloat ambientLight[4];
+    GLfloat fogColor[4];
+    GLfloat fogRange[4];
+    GLfloat lightmapPlane[4];
+};
+
+struct MaterialBlock {
+    GLfloat color[4];
+    GLint flags[4];
+};
+
+// Общие части шейдеров; исходник программы собирается из них в initialize
+const char* versionLine = "#version 330 core\n";
+
+const char* frameBlock = R"(
+layout(std140) uniform Frame {
+    mat4 projection;
+    mat4 view;
+    vec4 lightPosition;
+    vec4 lightDiffuse;
+    vec4 ambientLight;
+    vec4 fogColor;
+    vec4 fogRange;
+    vec4 lightmapPlane;
+};
+)";
+
+const char* materialBlock = R"(
+layout(std140) uniform Material {
+    vec4 color;
+    ivec4 flags;
+};
+)";
+
+// Пол, выход и затемняющий квад: вершины уже в мировых координатах
+const char* meshVertexShader = R"(
+in vec3 position;
+in vec3 normal;
+in vec2 texCoord;
+out vec3 eyePosition;
+out vec3 eyeNormal;
+out vec2 surfaceCoord;
+out vec2 floorCoord;
+
+void main() {
+    vec4 eye = view * vec4(position, 1.0);
+    gl_Position = projection * eye;
+    eyePosition = eye.xyz;
+    eyeNormal = mat3(view) * normal;
+    surfaceCoord = texCoord;
+    floorCoord = position.xz;
+}
+)";
+
+// Единичный бокс, растянутый на экземпляр (x, z, w, h): нормали граней от растяжения вдоль осей не
+// меняются. texCoord - доля высоты и выбор мировой координаты для u, как у шейдера стен Renderer
+const char* wallVertexShader = R"(
+in vec3 position;
+in vec3 normal;
+in vec2 texCoord;
+in vec4 wall;
+out vec3 eyePosition;
+out vec3 eyeNormal;
+out vec2 surfaceCoord;
+out vec2 floorCoord;
+
+void main() {
+    vec3 world = vec3(wall.x + position.x * wall.z, position.y, wall.y + position.z * wall.w);
+    vec4 eye = view * vec4(world, 1.0);
+    gl_Position = projection * eye;
+    eyePosition = eye.xyz;
+    eyeNormal = mat3(view) * normal;
+    surfaceCoord = vec2(mix(world.x, world.z, texCoord.y) * 0.5, texCoord.x);
+    floorCoord = world.xz;
+}
+)";
+
+// Освещение фиксированного конвейера с GL_COLOR_MATERIAL (фоновое сцены, рассеянное источника 0
+// без ослабления), но по пикселю; текстура и карта освещения умножаются, линейный туман по глубине
+const char* sceneFragmentShader = R"(
+uniform sampler2D surfaceTexture;
+uniform sampler2D lightmapTexture;
+in vec3 eyePosition;
+in vec3 eyeNormal;
+in vec2 surfaceCoord;
+in vec2 floorCoord;
+out vec4 fragColor;
+
+void main() {
+    vec4 result = color;
+    if (flags.y != 0) {
+        vec3 toLight = normalize(lightPosition.xyz - eyePosition * lightPosition.w);
+        float diffuse = max(dot(normalize(eyeNormal), toLight), 0.0);
+        result.rgb = clamp((ambientLight.rgb + diffuse * lightDiffuse.rgb) * color.rgb, 0.0, 1.0);
+    }
+    if (flags.x != 0) {
+        result *= texture(surfaceTexture, surfaceCoord);
+    }
+    if (flags.z != 0) {
+        result.rgb *= texture(lightmapTexture, floorCoord * lightmapPlane.xy + lightmapPlane.zw).r;
+    }
+    float fog = clamp((fogRange.y - abs(eyePosition.z)) * fogRange.z, 0.0, 1.0);
+    fragColor = vec4(mix(fogColor.rgb, result.rgb, fog), result.a);
+}
+)";
+
+// Объёмы теней пишут только в стенсил
+const char* shadowVertexShader = R"(
+in vec3 position;
+
+void main() {
+    gl_Position = projection * view * vec4(position, 1.0);
+}
+)";
+
+const char* shadowFragmentShader = R"(
+void main() {
+}
+)";
+
+// Матрицы по столбцам, как gluPerspective и gluLookAt
+void perspective(float fovY, float aspect, float zNear, float zFar, GLfloat* m) {
+    float f = 1.0f / std::tan(fovY * 3.14159265f / 360.0f);
+    std::fill(m, m + 16, 0.0f);
+    m[0] = f / aspect;
+    m[5] = f;
+    m[10] = (zFar + zNear) / (zNear - zFar);
+    m[11] = -1.0f;
+    m[14] = 2.0f * zFar * zNear / (zNear - zFar);
+}
+
+void lookAt(const float* eye, const float* center, const float* up, GLfloat* m) {
+    auto normalize = [](float* v) {
+        float length = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    };
+    auto cross = [](const float* a, const float* b, float* result) {
+        result[0] = a[1] * b[2] - a[2] * b[1];
+        result[1] = a[2] * b[0] - a[0] * b[2];
+        result[2] = a[0] * b[1] - a[1] * b[0];
+    };
+    float forward[3] = { center[0] - eye[0], center[1] - eye[1], center[2] - eye[2] };
+    normalize(forward);
+    float side[3], upward[3];
+    cross(forward, up, side);
+    normalize(side);
+    cross(side, forward, upward);
+
+    for (int k = 0; k < 3; k++) {
+        m[k * 4] = side[k];
+        m[k * 4 + 1] = upward[k];
+        m[k * 4 + 2] = -forward[k];
+        m[k * 4 + 3] = 0.0f;
+    }
+    m[12] = -(side[0] * eye[0] + side[1] * eye[1] + side[2] * eye[2]);
+    m[13] = -(upward[0] * eye[0] + upward[1] * eye[1] + upward[2] * eye[2]);
+    m[14] = forward[0] * eye[0] + forward[1] * eye[1] + forward[2] * eye[2];
+    m[15] = 1.0f;
+}
+
+}
+
+bool CoreRenderer::initialize() {
+    std::vector<std::pair<GLuint, const char*>> attributes = {
+        { positionAttribute, "position" }, { normalAttribute, "normal" }, { texCoordAttribute, "texCoord" }, { wallAttribute, "wall" }
+    };
+    std::string vertexHeader = std::string(versionLine) + frameBlock;
+    std::string fragmentHeader = vertexHeader + materialBlock;
+    if (!meshProgram.build((vertexHeader + meshVertexShader).c_str(), (fragmentHeader + sceneFragmentShader).c_str(), attributes)
+        || !wallProgram.build((vertexHeader + wallVertexShader).c_str(), (fragmentHeader + sceneFragmentShader).c_str(), attributes)
+        || !shadowProgram.build((vertexHeader + shadowVertexShader).c_str(), (std::string(versionLine) + shadowFragmentShader).c_str(),
+                                { { positionAttribute, "position" } })) {
+        return false;
+    }
+    for (const ShaderProgram* program : { &meshProgram, &wallProgram, &shadowProgram }) {
+        program->bindUniformBlock("Frame", frameBinding);
+        program->bindUniformBlock("Material", materialBinding);
+        GLExtensions::useProgram(program->getId());
+        GLExtensions::uniform1i(program->getUniform("surfaceTexture"), 0);
+        GLExtensions::uniform1i(program->getUniform("lightmapTexture"), 1);
+    }
+    GLExtensions::useProgram(0);
+
+    GLExtensions::genVertexArrays(1, &meshArray);
+    GLExtensions::genVertexArrays(1, &wallArray);
+    GLExtensions::genVertexArrays(1, &shadowArray);
+    GLExtensions::genBuffers(1, &meshBuffer);
+
+    // Блоки всех материалов лежат в одном буфере, к точке привязки подключается нужный диапазон
+    GLint alignment = 1;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    materialStride = (sizeof(MaterialBlock) + alignment - 1) / alignment * alignment;
+    GLExtensions::genBuffers(1, &frameUniforms);
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, frameUniforms);
+    GLExtensions::bufferData(GL_UNIFORM_BUFFER, sizeof(FrameBlock), nullptr, GL_DYNAMIC_DRAW);
+    GLExtensions::genBuffers(1, &materialUniforms);
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, materialUniforms);
+    GLExtensions::bufferData(GL_UNIFORM_BUFFER, materialStride * MATERIAL_COUNT, nullptr, GL_STATIC_DRAW);
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, 0);
+    return true;
+}
+
+void CoreRenderer::buildLevelGeometry() {
+    const Maze& maze = Maze::getInstance();
+    float halfWidth = maze.getWidth() / 2;
+    float halfHeight = maze.getHeight() / 2;
+
+    // Пол и затемняющий квад теней - на весь лабиринт; текстура пола повторяется через две единицы
+    std::vector<Renderer::WallVertex> vertices;
+    auto addQuad = [&](float y) {
+        const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+        for (const float* corner : corners) {
+            float x = corner[0] * halfWidth, z = corner[1] * halfHeight;
+            vertices.push_back({ (x + halfWidth) / 2.0f, (z + halfHeight) / 2.0f, 0.0f, 1.0f, 0.0f, x, y, z });
+        }
+    };
+    floorFirst = (GLint)vertices.size();
+    addQuad(-1.0f);
+    shadowQuadFirst = (GLint)vertices.size();
+    addQuad(-0.99f);
+
+    // Выход - куб со стороной 0.5, как glutSolidCube в Renderer::drawExit
+    exitFirst = (GLint)vertices.size();
+    const float exitCenter[3] = { maze.getExitX(), -0.5f, maze.getExitZ() };
+    const float half = 0.25f;
+    for (int axis = 0; axis < 3; axis++) {
+        for (float sign : { -1.0f, 1.0f }) {
+            int u = (axis + 1) % 3, v = (axis + 2) % 3;
+            const float corners[6][2] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+            for (const float* corner : corners) {
+                float position[3], normal[3] = { 0.0f, 0.0f, 0.0f };
+                position[axis] = exitCenter[axis] + sign * half;
+                position[u] = exitCenter[u] + corner[0] * half;
+                position[v] = exitCenter[v] + corner[1] * half;
+                normal[axis] = sign;
+                vertices.push_back({ 0.0f, 0.0f, normal[0], normal[1], normal[2], position[0], position[1], position[2] });
+            }
+        }
+    }
+
+    GLExtensions::bindVertexArray(meshArray);
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, meshBuffer);
+    GLExtensions::bufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Renderer::WallVertex), vertices.data(), GL_STATIC_DRAW);
+    GLsizei stride = sizeof(Renderer::WallVertex);
+    GLExtensions::vertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offsetof(Renderer::WallVertex, x));
+    GLExtensions::vertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offsetof(Renderer::WallVertex, nx));
+    GLExtensions::vertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offsetof(Renderer::WallVertex, u));
+    GLExtensions::enableVertexAttribArray(positionAttribute);
+    GLExtensions::enableVertexAttribArray(normalAttribute);
+    GLExtensions::enableVertexAttribArray(texCoordAttribute);
+
+    // Стены: единичный бокс и буфер экземпляров Renderer. Указатель экземпляров ставится
+    // на каждый вызов в flush
+    GLExtensions::bindVertexArray(wallArray);
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, Renderer::unitBoxBuffer);
+    stride = sizeof(Renderer::UnitBoxVertex);
+    GLExtensions::vertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offsetof(Renderer::UnitBoxVertex, x));
+    GLExtensions::vertexAttribPointer(normalAttribute, 3, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offsetof(Renderer::UnitBoxVertex, nx));
+    GLExtensions::vertexAttribPointer(texCoordAttribute, 2, GL_FLOAT, GL_FALSE, stride, (const GLvoid*)offsetof(Renderer::UnitBoxVertex, v));
+    GLExtensions::enableVertexAttribArray(positionAttribute);
+    GLExtensions::enableVertexAttribArray(normalAttribute);
+    GLExtensions::enableVertexAttribArray(texCoordAttribute);
+    GLExtensions::enableVertexAttribArray(wallAttribute);
+    GLExtensions::vertexAttribDivisor(wallAttribute, 1);
+
+    // Объёмы теней есть только в стенсильном режиме
+    GLExtensions::bindVertexArray(shadowArray);
+    if (Renderer::shadowVertexBuffer) {
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, Renderer::shadowVertexBuffer);
+        GLExtensions::vertexAttribPointer(positionAttribute, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        GLExtensions::enableVertexAttribArray(positionAttribute);
+    }
+    GLExtensions::bindVertexArray(0);
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    updateMaterials();
+}
+
+void CoreRenderer::updateMaterials() {
+    // Цвета те же, что задаёт glColor в Renderer: без текстуры пол серый, а стены жёлтые
+    bool floorLightmap = Renderer::shadowMode == ShadowMode::LIGHTMAP && Renderer::lightmapTexture;
+    MaterialBlock blocks[MATERIAL_COUNT] = {
+        { { 1.0f, 1.0f, 1.0f, 1.0f }, { Renderer::floorTexture != 0, 1, floorLightmap, 0 } },
+        { { 1.0f, 1.0f, 1.0f, 1.0f }, { Renderer::wallTexture != 0, 1, 0, 0 } },
+        { { 1.0f, 0.0f, 0.0f, 1.0f }, { 0, 0, 0, 0 } },
+        { { 0.0f, 0.0f, 0.0f, 0.5f }, { 0, 0, 0, 0 } }
+    };
+    if (!Renderer::floorTexture) {
+        std::fill(blocks[FLOOR].color, blocks[FLOOR].color + 3, 0.5f);
+    }
+    if (!Renderer::wallTexture) {
+        blocks[WALL].color[2] = 0.0f;
+    }
+    materialTextures[FLOOR] = Renderer::floorTexture;
+    materialTextures[WALL] = Renderer::wallTexture;
+    materialTextures[EXIT] = 0;
+    materialTextures[SHADOW] = 0;
+
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, materialUniforms);
+    for (int material = 0; material < MATERIAL_COUNT; material++) {
+        GLExtensions::bufferSubData(GL_UNIFORM_BUFFER, material * materialStride, sizeof(MaterialBlock), &blocks[material]);
+    }
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void CoreRenderer::updateFrame(const GLfloat* projection, const GLfloat* view) {
+    FrameBlock frame;
+    std::copy_n(projection, 16, frame.projection);
+    std::copy_n(view, 16, frame.view);
+    // Свет задаётся в мире, как glLightfv после gluLookAt в Renderer::drawScene
+    for (int row = 0; row < 4; row++) {
+        frame.lightPosition[row] = 0.0f;
+        for (int k = 0; k < 4; k++) {
+            frame.lightPosition[row] += view[k * 4 + row] * Renderer::lightPos[k];
+        }
+    }
+    std::copy_n(Renderer::lightDiffuse, 4, frame.lightDiffuse);
+    std::copy_n(Renderer::ambientLight, 4, frame.ambientLight);
+    std::copy_n(Renderer::fogColor, 4, frame.fogColor);
+    frame.fogRange[0] = Renderer::fogStart;
+    frame.fogRange[1] = Renderer::fogEnd;
+    frame.fogRange[2] = 1.0f / (Renderer::fogEnd - Renderer::fogStart);
+    frame.fogRange[3] = 0.0f;
+    // Как плоскости glTexGen в Renderer::enableFloorLightmap
+    const Maze& maze = Maze::getInstance();
+    frame.lightmapPlane[0] = 1.0f / maze.getWidth();
+    frame.lightmapPlane[1] = 1.0f / maze.getHeight();
+    frame.lightmapPlane[2] = 0.5f;
+    frame.lightmapPlane[3] = 0.5f;
+
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, frameUniforms);
+    GLExtensions::bufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameBlock), &frame);
+    GLExtensions::bindBuffer(GL_UNIFORM_BUFFER, 0);
+    GLExtensions::bindBufferRange(GL_UNIFORM_BUFFER, frameBinding, frameUniforms, 0, sizeof(FrameBlock));
+}
+
+void CoreRenderer::drawScene(bool showMiniMap) {
+    glClearColor(Renderer::fogColor[0], Renderer::fogColor[1], Renderer::fogColor[2], Renderer::fogColor[3]);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+
+    GLfloat projection[16], view[16];
+    perspective(45.0f, 800.0f / 600.0f, 0.1f, 100.0f, projection);
+    const float eye[3] = { Player::getRenderX(), Player::getY(), Player::getRenderZ() };
+    const float center[3] = { eye[0] + std::sin(Player::getRenderAngle()), eye[1], eye[2] + std::cos(Player::getRenderAngle()) };
+    const float up[3] = { 0.0f, 1.0f, 0.0f };
+    lookAt(eye, center, up, view);
+    updateFrame(projection, view);
+
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDisable(GL_STENCIL_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_BLEND);
+
+    const GLfloat* lightPos = Renderer::lightPos;
+    const GLfloat* shadowLightPos = Renderer::shadowLightPos;
+    bool lightMoved = lightPos[0] != shadowLightPos[0] || lightPos[1] != shadowLightPos[1] || lightPos[2] != shadowLightPos[2];
+    if (Renderer::shadowMode == ShadowMode::LIGHTMAP && Renderer::lightmapTexture) {
+        if (lightMoved) {
+            Renderer::bakeFloorLightmap();
+        }
+        GLExtensions::activeTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, Renderer::lightmapTexture);
+        GLExtensions::activeTexture(GL_TEXTURE0);
+    }
+
+    submit({ MESH, FLOOR, floorFirst, 6, 0, 0 });
+
+    // Отсечение стен общее с Renderer::drawWalls; соседние по номеру кластеры - один вызов
+    Renderer::drawnWallCount = 0;
+    Renderer::occludedClusterCount = 0;
+    int wallCount = (int)(Maze::getInstance().getWalls().size() / 4);
+    if (!Renderer::wallClusters.empty()) {
+        std::vector<int> visible;
+        float eyeX, eyeZ;
+        Renderer::collectVisibleClusters(projection, view, visible, eyeX, eyeZ);
+        for (size_t k = 0, first = 0; k < visible.size(); k++) {
+            Renderer::drawnWallCount += Renderer::wallClusters[visible[k]].wallCount;
+            if (k + 1 == visible.size() || visible[k + 1] != visible[k] + 1) {
+                const Renderer::WallCluster& begin = Renderer::wallClusters[visible[first]];
+                const Renderer::WallCluster& end = Renderer::wallClusters[visible[k]];
+                submit({ WALLS, WALL, 0, Renderer::unitBoxVertexCount, end.firstWall + end.wallCount - begin.firstWall, begin.firstWall });
+                first = k + 1;
+            }
+        }
+    }
+    Renderer::culledWallCount = wallCount - Renderer::drawnWallCount;
+
+    submit({ MESH, EXIT, exitFirst, 36, 0, 0 });
+    flush();
+
+    if (Renderer::shadowMode == ShadowMode::STENCIL) {
+        drawShadows();
+    }
+
+    GLExtensions::useProgram(0);
+    GLExtensions::bindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    // Мини-карта с текстом GLUT рисуется фиксированным конвейером: окно создаётся с профилем совместимости
+    if (showMiniMap) {
+        Renderer::drawMiniMap();
+    }
+
+    glutSwapBuffers();
+}
+
+void CoreRenderer::drawShadows() {
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_STENCIL_TEST);
+    glEnable(GL_CULL_FACE);
+
+    const GLfloat* lightPos = Renderer::lightPos;
+    const GLfloat* shadowLightPos = Renderer::shadowLightPos;
+    if (lightPos[0] != shadowLightPos[0] || lightPos[1] != shadowLightPos[1] || lightPos[2] != shadowLightPos[2]) {
+        Renderer::buildShadowVolumes();
+    }
+    GLExtensions::useProgram(shadowProgram.getId());
+    GLExtensions::bindVertexArray(shadowArray);
+    Renderer::countShadowVolumes();
+
+    // Затемнение пола там, где счётчик не ноль
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glStencilFunc(GL_NOTEQUAL, 0, ~0);
+    submit({ MESH, SHADOW, shadowQuadFirst, 6, 0, 0 });
+    flush();
+
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glDisable(GL_STENCIL_TEST);
+}
+
+void CoreRenderer::submit(const DrawCommand& command) {
+    queue.push_back(command);
+}
+
+void CoreRenderer::flush() {
+    std::stable_sort(queue.begin(), queue.end(), [](const DrawCommand& a, const DrawCommand& b) {
+        return a.geometry != b.geometry ? a.geometry < b.geometry : a.material < b.material;
+    });
+
+    int geometry = -1, material = -1;
+    for (const DrawCommand& command : queue) {
+        if (command.geometry != geometry) {
+            geometry = command.geometry;
+            GLExtensions::useProgram(geometry == WALLS ? wallProgram.getId() : meshProgram.getId());
+            GLExtensions::bindVertexArray(geometry == WALLS ? wallArray : meshArray);
+            GLExtensions::bindBuffer(GL_ARRAY_BUFFER, geometry == WALLS ? Renderer::wallInstanceBuffer : 0);
+        }
+        if (command.material != material) {
+            material = command.material;
+            glBindTexture(GL_TEXTURE_2D, materialTextures[material]);
+            GLExtensions::bindBufferRange(GL_UNIFORM_BUFFER, materialBinding, materialUniforms, material * materialStride, sizeof(MaterialBlock));
+        }
+        if (command.instanceCount > 0) {
+            GLExtensions::vertexAttribPointer(wallAttribute, 4, GL_FLOAT, GL_FALSE, 0,
+                                              (const GLvoid*)(command.firstInstance * 4 * sizeof(GLfloat)));
+            GLExtensions::drawArraysInstanced(GL_TRIANGLES, command.first, command.count, command.instanceCount);
+        } else {
+            glDrawArrays(GL_TRIANGLES, command.first, command.count);
+        }
+    }
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+    queue.clear();
+}
@@ -0,0 +1,55 @@
+#ifndef CORE_RENDERER_H
+#define CORE_RENDERER_H
+
+#include <GL/freeglut.h>
+#include <vector>
+#include "ShaderProgram.h"
+
+// Сцена Renderer::drawScene на OpenGL 3.3 core: VAO, освещение и туман по пикселям в шейдерах,
+// данные кадра в uniform-буфере. Кластеры стен, их экземпляры, отсечение и объёмы теней общие
+// с Renderer. Вызовы отрисовки копятся в очереди и перед выполнением сортируются по программе
+// и материалу: текстура и блок материала меняются один раз на группу вызовов
+class CoreRenderer {
+public:
+    // Программы и буферы, не зависящие от уровня; false - шейдеры не собрались
+    static bool initialize();
+    // Вызывается из Renderer::buildLevelGeometry: пол, выход, VAO над буферами уровня, материалы
+    static void buildLevelGeometry();
+    static void drawScene(bool showMiniMap);
+
+private:
+    // Материал - всё состояние вызова, кроме геометрии: текстура и содержимое блока Material
+    enum Material { FLOOR, WALL, EXIT, SHADOW, MATERIAL_COUNT };
+    // Геометрия задаёт программу и VAO
+    enum Geometry { MESH, WALLS };
+
+    struct DrawCommand {
+        Geometry geometry;
+        Material material;
+        GLint first;
+        GLsizei count;
+        GLsizei instanceCount;  // 0 - без экземпляров
+        GLint firstInstance;    // В GL 3.3 нет baseInstance: на столько сдвигается указатель атрибута экземпляров
+    };
+
+    static void updateFrame(const GLfloat* projection, const GLfloat* view);
+    static void updateMaterials();
+    static void submit(const DrawCommand& command);
+    // Выполняет очередь, сгруппировав по программе и материалу; порядок внутри группы сохраняется
+    static void flush();
+    static void drawShadows();
+
+    static ShaderProgram meshProgram;
+    static ShaderProgram wallProgram;
+    static ShaderProgram shadowProgram;
+    static GLuint meshArray, wallArray, shadowArray;
+    static GLuint meshBuffer;
+    static GLuint frameUniforms;
+    static GLuint materialUniforms;
+    static GLsizeiptr materialStride;  // Размер блока материала, выровненный под GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    static GLuint materialTextures[MATERIAL_COUNT];
+    static GLint floorFirst, shadowQuadFirst, exitFirst;
+    static std::vector<DrawCommand> queue;
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "DistanceField.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+
+DistanceField::DistanceField() : originX(0.0f), originZ(0.0f), cellSize(1.0f), cols(0), rows(0) {}
+
+void DistanceField::clear() {
+    cols = 0;
+    rows = 0;
+    distance.clear();
+}
+
+void DistanceField::build(const OccupancyGrid& grid) {
+    clear();
+    if (grid.getCols() == 0) {
+        return;
+    }
+    cols = grid.getCols();
+    rows = grid.getRows();
+    cellSize = grid.getCellSize();
+    originX = grid.getOriginX();
+    originZ = grid.getOriginZ();
+    distance.assign((size_t)cols * rows, 0.0f);
+
+    // Проход по столбцам: квадрат расстояния до ближайшей занятой ячейки того же столбца
+    const double infinity = INFINITY;
+    std::vector<double> columnDistance((size_t)cols * rows);
+    parallelBands(cols, parallelBandCount(cols), [&](int, int colBegin, int colEnd) {
+        for (int col = colBegin; col < colEnd; col++) {
+            double last = -infinity;
+            for (int row = 0; row < rows; row++) {
+                if (grid.isCellBlocked(col, row)) {
+                    last = row;
+                }
+                columnDistance[(size_t)row * cols + col] = row - last;
+            }
+            last = infinity;
+            for (int row = rows - 1; row >= 0; row--) {
+                if (grid.isCellBlocked(col, row)) {
+                    last = row;
+                }
+                double& d = columnDistance[(size_t)row * cols + col];
+                d = std::min(d, last - row);
+                d *= d;
+            }
+        }
+    });
+
+    // Проход по строкам: нижняя огибающая парабол (q - v)^2 + f(v) по ячейкам с конечным f
+    parallelBands(rows, parallelBandCount(rows), [&](int, int rowBegin, int rowEnd) {
+        std::vector<int> sites(cols);
+        std::vector<double> bounds(cols + 1);
+        for (int row = rowBegin; row < rowEnd; row++) {
+            const double* f = columnDistance.data() + (size_t)row * cols;
+            float* out = distance.data() + (size_t)row * cols;
+            int count = 0;
+            for (int q = 0; q < cols; q++) {
+                if (std::isinf(f[q])) {
+                    continue;
+                }
+                // Пересечение параболы q с последней параболой огибающей
+                double s = 0.0;
+                while (count > 0) {
+                    int v = sites[count - 1];
+                    s = ((f[q] + (double)q * q) - (f[v] + (double)v * v)) / (2.0 * (q - v));
+                    if (s > bounds[count - 1]) {
+                        break;
+                    }
+                    count--;
+                }
+                sites[count] = q;
+                bounds[count] = count == 0 ? -infinity : s;
+                count++;
+            }
+            if (count == 0) {
+                std::fill(out, out + cols, (float)infinity);
+                continue;
+            }
+            int k = 0;
+            for (int q = 0; q < cols; q++) {
+                while (k + 1 < count && bounds[k + 1] < q) {
+                    k++;
+                }
+                double dq = q - sites[k];
+                out[q] = (float)(std::sqrt(dq * dq + f[sites[k]]) * cellSize);
+            }
+        }
+    });
+}
+
+int DistanceField::nearestCell(float x, float z, float& offset) const {
+    int col = std::max(0, std::min(cols - 1, (int)std::floor((x - originX) / cellSize)));
+    int row = std::max(0, std::min(rows - 1, (int)std::floor((z - originZ) / cellSize)));
+    float dx = x - (originX + (col + 0.5f) * cellSize);
+    float dz = z - (originZ + (row + 0.5f) * cellSize);
+    offset = std::sqrt(dx * dx + dz * dz);
+    return row * cols + col;
+}
+
+float DistanceField::getLowerBound(float x, float z) const {
+    if (cols == 0) {
+        return INFINITY;
+    }
+    float offset;
+    int cell = nearestCell(x, z, offset);
+    return std::max(0.0f, distance[cell] - offset - cellSize * 0.70711f);
+}
+
+float DistanceField::getUpperBound(float x, float z) const {
+    if (cols == 0) {
+        return INFINITY;
+    }
+    float offset;
+    int cell = nearestCell(x, z, offset);
+    return distance[cell] + offset + cellSize * 0.70711f;
+}
@@ -0,0 +1,38 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <vector>
+#include "OccupancyGrid.h"
+
+// Евклидово расстояние от центра каждой ячейки OccupancyGrid до центра ближайшей занятой ячейки.
+// Считается один раз при загрузке (Felzenszwalb-Huttenlocher: проход по столбцам, затем
+// нижняя огибающая парабол по строкам; оба прохода параллельно по полосам)
+class DistanceField {
+public:
+    DistanceField();
+    void build(const OccupancyGrid& grid);
+    void clear();
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    bool isEmpty() const { return cols == 0; }
+    // Расстояние в единицах карты; INFINITY, если занятых ячеек нет
+    float getCellDistance(int col, int row) const { return distance[(size_t)row * cols + col]; }
+
+    // Оценки расстояния от точки до ближайшей стены: стена лежит в занятой ячейке,
+    // поэтому точное значение отличается от табличного не больше чем на полдиагонали ячейки
+    // плюс смещение точки от центра своей ячейки
+    float getLowerBound(float x, float z) const;
+    float getUpperBound(float x, float z) const;
+
+private:
+    // Ячейка с точкой, прижатая к сетке, и расстояние от точки до её центра
+    int nearestCell(float x, float z, float& offset) const;
+
+    float originX, originZ;
+    float cellSize;
+    int cols, rows;
+    std::vector<float> distance;
+};
+
+#endif
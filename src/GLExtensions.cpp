@@ -0,0 +1,140 @@
+#include "GLExtensions.h"
+#include <cstdio>
+
+PFNGLGENBUFFERSPROC GLExtensions::genBuffers = nullptr;
+PFNGLDELETEBUFFERSPROC GLExtensions::deleteBuffers = nullptr;
+PFNGLBINDBUFFERPROC GLExtensions::bindBuffer = nullptr;
+PFNGLBUFFERDATAPROC GLExtensions::bufferData = nullptr;
+
+PFNGLACTIVETEXTUREPROC GLExtensions::activeTexture = nullptr;
+
+PFNGLGENQUERIESPROC GLExtensions::genQueries = nullptr;
+PFNGLDELETEQUERIESPROC GLExtensions::deleteQueries = nullptr;
+PFNGLBEGINQUERYPROC GLExtensions::beginQuery = nullptr;
+PFNGLENDQUERYPROC GLExtensions::endQuery = nullptr;
+PFNGLGETQUERYIVPROC GLExtensions::getQueryiv = nullptr;
+PFNGLGETQUERYOBJECTUIVPROC GLExtensions::getQueryObjectuiv = nullptr;
+PFNGLBEGINCONDITIONALRENDERPROC GLExtensions::beginConditionalRender = nullptr;
+PFNGLENDCONDITIONALRENDERPROC GLExtensions::endConditionalRender = nullptr;
+
+PFNGLCREATESHADERPROC GLExtensions::createShader = nullptr;
+PFNGLDELETESHADERPROC GLExtensions::deleteShader = nullptr;
+PFNGLSHADERSOURCEPROC GLExtensions::shaderSource = nullptr;
+PFNGLCOMPILESHADERPROC GLExtensions::compileShader = nullptr;
+PFNGLGETSHADERIVPROC GLExtensions::getShaderiv = nullptr;
+PFNGLGETSHADERINFOLOGPROC GLExtensions::getShaderInfoLog = nullptr;
+PFNGLCREATEPROGRAMPROC GLExtensions::createProgram = nullptr;
+PFNGLDELETEPROGRAMPROC GLExtensions::deleteProgram = nullptr;
+PFNGLATTACHSHADERPROC GLExtensions::attachShader = nullptr;
+PFNGLBINDATTRIBLOCATIONPROC GLExtensions::bindAttribLocation = nullptr;
+PFNGLLINKPROGRAMPROC GLExtensions::linkProgram = nullptr;
+PFNGLGETPROGRAMIVPROC GLExtensions::getProgramiv = nullptr;
+PFNGLGETPROGRAMINFOLOGPROC GLExtensions::getProgramInfoLog = nullptr;
+PFNGLUSEPROGRAMPROC GLExtensions::useProgram = nullptr;
+PFNGLGETUNIFORMLOCATIONPROC GLExtensions::getUniformLocation = nullptr;
+PFNGLUNIFORM1IPROC GLExtensions::uniform1i = nullptr;
+PFNGLVERTEXATTRIBPOINTERPROC GLExtensions::vertexAttribPointer = nullptr;
+PFNGLENABLEVERTEXATTRIBARRAYPROC GLExtensions::enableVertexAttribArray = nullptr;
+PFNGLDISABLEVERTEXATTRIBARRAYPROC GLExtensions::disableVertexAttribArray = nullptr;
+
+PFNGLVERTEXATTRIBDIVISORPROC GLExtensions::vertexAttribDivisor = nullptr;
+PFNGLDRAWARRAYSINSTANCEDPROC GLExtensions::drawArraysInstanced = nullptr;
+
+PFNGLGENVERTEXARRAYSPROC GLExtensions::genVertexArrays = nullptr;
+PFNGLDELETEVERTEXARRAYSPROC GLExtensions::deleteVertexArrays = nullptr;
+PFNGLBINDVERTEXARRAYPROC GLExtensions::bindVertexArray = nullptr;
+PFNGLBUFFERSUBDATAPROC GLExtensions::bufferSubData = nullptr;
+PFNGLBINDBUFFERRANGEPROC GLExtensions::bindBufferRange = nullptr;
+PFNGLGETUNIFORMBLOCKINDEXPROC GLExtensions::getUniformBlockIndex = nullptr;
+PFNGLUNIFORMBLOCKBINDINGPROC GLExtensions::uniformBlockBinding = nullptr;
+
+bool GLExtensions::vertexBufferObjects = false;
+bool GLExtensions::multitexture = false;
+bool GLExtensions::occlusionQueries = false;
+bool GLExtensions::conditionalRender = false;
+bool GLExtensions::shaders = false;
+bool GLExtensions::instancing = false;
+bool GLExtensions::corePipeline = false;
+
+template <typename T>
+static bool loadProc(T& proc, const char* name) {
+    proc = reinterpret_cast<T>(glutGetProcAddress(name));
+    return proc != nullptr;
+}
+
+void GLExtensions::initialize() {
+    // glX возвращает адрес даже для неподдерживаемых функций, поэтому сначала смотрим на версию
+    vertexBufferObjects = versionAtLeast(1, 5)
+        && loadProc(genBuffers, "glGenBuffers")
+        && loadProc(deleteBuffers, "glDeleteBuffers")
+        && loadProc(bindBuffer, "glBindBuffer")
+        && loadProc(bufferData, "glBufferData");
+
+    multitexture = versionAtLeast(1, 3)
+        && loadProc(activeTexture, "glActiveTexture");
+
+    occlusionQueries = versionAtLeast(1, 5)
+        && loadProc(genQueries, "glGenQueries")
+        && loadProc(deleteQueries, "glDeleteQueries")
+        && loadProc(beginQuery, "glBeginQuery")
+        && loadProc(endQuery, "glEndQuery")
+        && loadProc(getQueryiv, "glGetQueryiv")
+        && loadProc(getQueryObjectuiv, "glGetQueryObjectuiv");
+    if (occlusionQueries) {
+        // Реализация вправе не иметь счётчика (0 бит), тогда запросы всегда возвращают 0
+        GLint counterBits = 0;
+        getQueryiv(GL_SAMPLES_PASSED, GL_QUERY_COUNTER_BITS, &counterBits);
+        occlusionQueries = counterBits > 0;
+    }
+
+    conditionalRender = occlusionQueries && versionAtLeast(3, 0)
+        && loadProc(beginConditionalRender, "glBeginConditionalRender")
+        && loadProc(endConditionalRender, "glEndConditionalRender");
+
+    shaders = versionAtLeast(2, 0)
+        && loadProc(createShader, "glCreateShader")
+        && loadProc(deleteShader, "glDeleteShader")
+        && loadProc(shaderSource, "glShaderSource")
+        && loadProc(compileShader, "glCompileShader")
+        && loadProc(getShaderiv, "glGetShaderiv")
+        && loadProc(getShaderInfoLog, "glGetShaderInfoLog")
+        && loadProc(createProgram, "glCreateProgram")
+        && loadProc(deleteProgram, "glDeleteProgram")
+        && loadProc(attachShader, "glAttachShader")
+        && loadProc(bindAttribLocation, "glBindAttribLocation")
+        && loadProc(linkProgram, "glLinkProgram")
+        && loadProc(getProgramiv, "glGetProgramiv")
+        && loadProc(getProgramInfoLog, "glGetProgramInfoLog")
+        && loadProc(useProgram, "glUseProgram")
+        && loadProc(getUniformLocation, "glGetUniformLocation")
+        && loadProc(uniform1i, "glUniform1i")
+        && loadProc(vertexAttribPointer, "glVertexAttribPointer")
+        && loadProc(enableVertexAttribArray, "glEnableVertexAttribArray")
+        && loadProc(disableVertexAttribArray, "glDisableVertexAttribArray");
+
+    instancing = shaders && vertexBufferObjects && versionAtLeast(3, 3)
+        && loadProc(vertexAttribDivisor, "glVertexAttribDivisor")
+        && loadProc(drawArraysInstanced, "glDrawArraysInstanced");
+
+    corePipeline = instancing
+        && loadProc(genVertexArrays, "glGenVertexArrays")
+        && loadProc(deleteVertexArrays, "glDeleteVertexArrays")
+        && loadProc(bindVertexArray, "glBindVertexArray")
+        && loadProc(bufferSubData, "glBufferSubData")
+        && loadProc(bindBufferRange, "glBindBufferRange")
+        && loadProc(getUniformBlockIndex, "glGetUniformBlockIndex")
+        && loadProc(uniformBlockBinding, "glUniformBlockBinding");
+
+    if (!vertexBufferObjects) {
+        printf("VBO недоступны, геометрия будет передаваться из памяти клиента\n");
+    }
+}
+
+bool GLExtensions::versionAtLeast(int major, int minor) {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int glMajor = 0, glMinor = 0;
+    if (!version || sscanf(version, "%d.%d", &glMajor, &glMinor) != 2) {
+        return false;
+    }
+    return glMajor > major || (glMajor == major && glMinor >= minor);
+}
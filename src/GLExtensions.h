@@ -0,0 +1,83 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <GL/freeglut.h>
+#include <GL/glext.h>
+
+// Функции OpenGL старше 1.1: opengl32 на Windows их не экспортирует,
+// поэтому адреса получаем через glutGetProcAddress после создания контекста
+class GLExtensions {
+public:
+    static void initialize();
+
+    static bool hasVertexBufferObjects() { return vertexBufferObjects; }
+    static bool hasMultitexture() { return multitexture; }
+    static bool hasOcclusionQueries() { return occlusionQueries; }
+    // Отрисовка по результату запроса видимости без ожидания на CPU (OpenGL 3.0)
+    static bool hasConditionalRender() { return conditionalRender; }
+    static bool hasShaders() { return shaders; }
+    // Атрибуты с делителем и glDrawArraysInstanced (OpenGL 3.3)
+    static bool hasInstancing() { return instancing; }
+    // Объекты массивов вершин и буферы uniform-блоков (OpenGL 3.3, шейдеры GLSL 3.30)
+    static bool hasCorePipeline() { return corePipeline; }
+
+    static PFNGLGENBUFFERSPROC genBuffers;
+    static PFNGLDELETEBUFFERSPROC deleteBuffers;
+    static PFNGLBINDBUFFERPROC bindBuffer;
+    static PFNGLBUFFERDATAPROC bufferData;
+
+    static PFNGLACTIVETEXTUREPROC activeTexture;
+
+    static PFNGLGENQUERIESPROC genQueries;
+    static PFNGLDELETEQUERIESPROC deleteQueries;
+    static PFNGLBEGINQUERYPROC beginQuery;
+    static PFNGLENDQUERYPROC endQuery;
+    static PFNGLGETQUERYIVPROC getQueryiv;
+    static PFNGLGETQUERYOBJECTUIVPROC getQueryObjectuiv;
+    static PFNGLBEGINCONDITIONALRENDERPROC beginConditionalRender;
+    static PFNGLENDCONDITIONALRENDERPROC endConditionalRender;
+
+    static PFNGLCREATESHADERPROC createShader;
+    static PFNGLDELETESHADERPROC deleteShader;
+    static PFNGLSHADERSOURCEPROC shaderSource;
+    static PFNGLCOMPILESHADERPROC compileShader;
+    static PFNGLGETSHADERIVPROC getShaderiv;
+    static PFNGLGETSHADERINFOLOGPROC getShaderInfoLog;
+    static PFNGLCREATEPROGRAMPROC createProgram;
+    static PFNGLDELETEPROGRAMPROC deleteProgram;
+    static PFNGLATTACHSHADERPROC attachShader;
+    static PFNGLBINDATTRIBLOCATIONPROC bindAttribLocation;
+    static PFNGLLINKPROGRAMPROC linkProgram;
+    static PFNGLGETPROGRAMIVPROC getProgramiv;
+    static PFNGLGETPROGRAMINFOLOGPROC getProgramInfoLog;
+    static PFNGLUSEPROGRAMPROC useProgram;
+    static PFNGLGETUNIFORMLOCATIONPROC getUniformLocation;
+    static PFNGLUNIFORM1IPROC uniform1i;
+    static PFNGLVERTEXATTRIBPOINTERPROC vertexAttribPointer;
+    static PFNGLENABLEVERTEXATTRIBARRAYPROC enableVertexAttribArray;
+    static PFNGLDISABLEVERTEXATTRIBARRAYPROC disableVertexAttribArray;
+
+    static PFNGLVERTEXATTRIBDIVISORPROC vertexAttribDivisor;
+    static PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced;
+
+    static PFNGLGENVERTEXARRAYSPROC genVertexArrays;
+    static PFNGLDELETEVERTEXARRAYSPROC deleteVertexArrays;
+    static PFNGLBINDVERTEXARRAYPROC bindVertexArray;
+    static PFNGLBUFFERSUBDATAPROC bufferSubData;
+    static PFNGLBINDBUFFERRANGEPROC bindBufferRange;
+    static PFNGLGETUNIFORMBLOCKINDEXPROC getUniformBlockIndex;
+    static PFNGLUNIFORMBLOCKBINDINGPROC uniformBlockBinding;
+
+private:
+    static bool versionAtLeast(int major, int minor);
+
+    static bool vertexBufferObjects;
+    static bool multitexture;
+    static bool occlusionQueries;
+    static bool conditionalRender;
+    static bool shaders;
+    static bool instancing;
+    static bool corePipeline;
+};
+
+#endif
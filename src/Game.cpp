@@ -3,22 +3,49 @@
 #include "Maze.h"
 #include "Player.h"
 #include "InputHandler.h"
+#include "LevelCache.h"
+#include "PixelClassifier.h"
 #include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 
 Game* Game::instance = nullptr;
 
-Game::Game() : state(GameState::MENU), showMiniMap(false), activeMessage(-1), currentLevel(""), windowWidth(800), windowHeight(600) {  // Инициализация размеров
+namespace {
+
+const char* const wallTexturePath = "../LabyrinthProject/wall_texture.png";
+const char* const floorTexturePath = "../LabyrinthProject/floor_texture.png";
+
+}
+
+Game::Game() : state(GameState::MENU), showMiniMap(false), activeMessage(-1), currentLevel(""), windowWidth(800), windowHeight(600),  // Инициализация размеров
+               tickRate(120), lastUpdateTime(0), accumulator(0.0), simulationActive(false),
+               loadingDone(false), loadingSucceeded(false), stateBeforeLoading(GameState::MENU) {
     instance = this;
 }
 
 void Game::initialize(int argc, char** argv) {
     glutInit(&argc, argv);
+    parseOptions(argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH | GLUT_STENCIL);
+    if (Renderer::getBackend() == RenderBackend::CORE) {
+        // Сцена рисуется только функциями 3.3 core, но меню, экран загрузки и мини-карта с текстом
+        // GLUT остаются на фиксированном конвейере - поэтому профиль совместимости
+        glutInitContextVersion(3, 3);
+        glutInitContextProfile(GLUT_COMPATIBILITY_PROFILE);
+    }
     glutInitWindowSize(800, 600);
     glutCreateWindow("3D Labyrinth with Shadows and Textures");
 
     Renderer::initialize();
 
+    // Для списка карт в меню читается только директория WAD
+    if (!wadPath.empty()) {
+        Maze::getInstance().openWAD(wadPath);
+    }
+
     glutDisplayFunc(displayCallback);
     glutReshapeFunc(reshapeCallback);
     glutKeyboardFunc(keyboardCallback);
@@ -26,16 +53,145 @@ void Game::initialize(int argc, char** argv) {
     glutSpecialFunc(specialKeyDownCallback);
     glutSpecialUpFunc(specialKeyUpCallback);
     glutMouseFunc(mouseCallback);
-    glutIdleFunc(updateCallback);
+    // Idle-функция ставится только пока идёт симуляция (см. wakeSimulation), иначе GLUT ждёт событий
 }
 
 void Game::run() {
     glutMainLoop();
 }
 
+void Game::parseOptions(int argc, char** argv) {
+    // glutInit уже убрал из argv свои параметры
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--shadows=stencil") {
+            Renderer::setShadowMode(ShadowMode::STENCIL);
+        } else if (arg == "--shadows=lightmap") {
+            Renderer::setShadowMode(ShadowMode::LIGHTMAP);
+        } else if (arg == "--walls=mesh") {
+            Renderer::setWallRendering(WallRendering::MESH);
+        } else if (arg == "--walls=instanced") {
+            Renderer::setWallRendering(WallRendering::INSTANCED);
+        } else if (arg == "--renderer=fixed") {
+            Renderer::setBackend(RenderBackend::FIXED_FUNCTION);
+        } else if (arg == "--renderer=core") {
+            Renderer::setBackend(RenderBackend::CORE);
+        } else if (arg == "--occlusion-queries") {
+            Renderer::setOcclusionCulling(true);
+        } else if (arg == "--benchmark-classifier") {
+            PixelClassifier::runBenchmark();
+            exit(0);
+        } else if (arg.rfind("--wad=", 0) == 0) {
+            instance->wadPath = arg.substr(strlen("--wad="));
+        } else if (arg.rfind("--cache-dir=", 0) == 0) {
+            LevelCache::setDirectory(arg.substr(strlen("--cache-dir=")));
+        } else if (arg.rfind("--occupancy-resolution=", 0) == 0) {
+            float resolution = (float)atof(arg.c_str() + strlen("--occupancy-resolution="));
+            if (resolution > 0.0f && resolution <= 64.0f) {
+                Maze::getInstance().setOccupancyResolution(resolution);
+            } else {
+                printf("Неверное разрешение карты занятости: %s\n", argv[i]);
+            }
+        } else if (arg.rfind("--tick-rate=", 0) == 0) {
+            int rate = atoi(arg.c_str() + strlen("--tick-rate="));
+            if (rate > 0) {
+                instance->tickRate = rate;
+            } else {
+                printf("Неверная частота симуляции: %s\n", argv[i]);
+            }
+        } else {
+            printf("Неизвестный параметр: %s\n", argv[i]);
+        }
+    }
+}
+
+bool Game::startLevel(const std::string& path, const std::string& mapName) {
+    if (state == GameState::LOADING) {
+        return false;
+    }
+
+    stateBeforeLoading = state;
+    loadingLevel = path;
+    loadingMap = mapName;
+    loadingDone = false;
+    Maze::getInstance().setLoadProgress(0.0f);
+    state = GameState::LOADING;
+
+    // Текстуры, уже загруженные в GL, повторно не декодируются
+    std::vector<std::string> texturesToDecode;
+    for (const char* texture : { wallTexturePath, floorTexturePath }) {
+        if (!TextureManager::isLoaded(texture)) {
+            texturesToDecode.push_back(texture);
+        }
+    }
+    loadingTextures.clear();
+
+    // В потоке только CPU-работа: декодирование уровня и текстур, выделение стен, сетка, кэш
+    loaderThread = std::thread([this, path, mapName, texturesToDecode]() {
+        loadingSucceeded = Maze::getInstance().loadLevel(path, mapName);
+        if (loadingSucceeded) {
+            for (const std::string& texture : texturesToDecode) {
+                TextureManager::Image image;
+                if (TextureManager::decode(texture, image)) {
+                    loadingTextures.push_back(std::move(image));
+                }
+            }
+        }
+        loadingDone = true;
+    });
+
+    glutTimerFunc(30, loadingTimerCallback, 0);
+    glutPostRedisplay();
+    return true;
+}
+
+void Game::loadingTimerCallback(int) {
+    if (!instance->loadingDone) {
+        glutPostRedisplay();  // Обновляем полосу прогресса
+        glutTimerFunc(30, loadingTimerCallback, 0);
+        return;
+    }
+    instance->loaderThread.join();
+    instance->finishLevelLoad();
+}
+
+void Game::finishLevelLoad() {
+    if (!loadingSucceeded) {
+        state = stateBeforeLoading;
+        glutPostRedisplay();
+        return;
+    }
+
+    // Всё, что трогает GL, - в главном потоке: здесь только загрузка готовых данных
+    auto decoded = [&](const char* filename) -> const TextureManager::Image* {
+        for (const TextureManager::Image& image : loadingTextures) {
+            if (image.filename == filename) {
+                return &image;
+            }
+        }
+        return nullptr;
+    };
+    Renderer::loadTexture(wallTexturePath, Renderer::wallTexture, decoded(wallTexturePath));
+    Renderer::loadTexture(floorTexturePath, Renderer::floorTexture, decoded(floorTexturePath));
+    loadingTextures.clear();
+    Renderer::buildLevelGeometry();
+
+    Maze& maze = Maze::getInstance();
+    currentLevel = loadingLevel;
+    currentMap = loadingMap;
+    activeMessage = -1;
+    showMiniMap = false;
+    maze.resetPlayerPosition();
+    state = GameState::PLAYING;
+    wakeSimulation();
+    glutPostRedisplay();
+}
+
 void Game::displayCallback() {
     if (instance->getState() == GameState::MENU) {
         Renderer::drawMenu();
+    } else if (instance->getState() == GameState::LOADING) {
+        Renderer::drawLoadingScreen(Maze::getInstance().getLoadProgress());
     } else if (instance->getState() == GameState::WIN) {
         Renderer::drawWinScreen(instance->getActiveMessage());
     } else {
@@ -51,6 +207,7 @@ void Game::reshapeCallback(int w, int h) {
 
 void Game::keyboardCallback(unsigned char key, int x, int y) {
     InputHandler::keyboard(key, x, y, *instance);
+    instance->wakeSimulation();
 }
 
 void Game::keyboardUpCallback(unsigned char key, int x, int y) {
@@ -59,6 +216,7 @@ void Game::keyboardUpCallback(unsigned char key, int x, int y) {
 
 void Game::specialKeyDownCallback(int key, int x, int y) {
     InputHandler::specialKeyDown(key, x, y);
+    instance->wakeSimulation();
 }
 
 void Game::specialKeyUpCallback(int key, int x, int y) {
@@ -69,8 +227,41 @@ void Game::mouseCallback(int button, int state, int x, int y) {
     InputHandler::mouse(button, state, x, y, *instance);
 }
 
+bool Game::isSimulationNeeded() const {
+    return state == GameState::PLAYING && InputHandler::isMovementKeyPressed();
+}
+
+void Game::wakeSimulation() {
+    if (simulationActive || !isSimulationNeeded()) {
+        return;
+    }
+    simulationActive = true;
+    lastUpdateTime = glutGet(GLUT_ELAPSED_TIME);
+    accumulator = 0.0;
+    glutIdleFunc(updateCallback);
+}
+
 void Game::updateCallback() {
-    if (instance->getState() == GameState::PLAYING) {
-        Player::update(*instance);
+    Game& game = *instance;
+    double tickInterval = 1.0 / game.tickRate;
+
+    int now = glutGet(GLUT_ELAPSED_TIME);
+    // Ограничиваем шаг, чтобы после долгой паузы не считать сотни тиков подряд
+    game.accumulator += std::min((now - game.lastUpdateTime) / 1000.0, 0.25);
+    game.lastUpdateTime = now;
+
+    while (game.accumulator >= tickInterval && game.getState() == GameState::PLAYING) {
+        Player::storePreviousState();
+        Player::update(game, (float)tickInterval);
+        game.accumulator -= tickInterval;
+    }
+    Player::setInterpolation((float)(game.accumulator / tickInterval));
+
+    if (!game.isSimulationNeeded()) {
+        // Ничего не меняется: показываем последнее состояние и ждём событий
+        Player::storePreviousState();
+        game.simulationActive = false;
+        glutIdleFunc(nullptr);
     }
+    glutPostRedisplay();
 }
\ No newline at end of file
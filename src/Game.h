@@ -3,8 +3,12 @@
 
 #include <GL/freeglut.h>
 #include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include "TextureManager.h"
 
-enum class GameState { MENU, PLAYING, WIN };
+enum class GameState { MENU, LOADING, PLAYING, WIN };
 
 class Game {
 public:
@@ -21,8 +25,13 @@ public:
     void setActiveMessage(int msg) { activeMessage = msg; }
     std::string getCurrentLevel() const { return currentLevel; }
     void setCurrentLevel(const std::string& level) { currentLevel = level; }
+    std::string getCurrentMap() const { return currentMap; }
+    // Фоновая загрузка уровня из PNG или карты mapName из WAD (состояние LOADING), затем PLAYING
+    bool startLevel(const std::string& path, const std::string& mapName = "");
     int getWindowWidth() const { return windowWidth; }
     int getWindowHeight() const { return windowHeight; }
+    int getTickRate() const { return tickRate; }
+    void wakeSimulation();
 
     static Game* instance;
     static void displayCallback();
@@ -32,9 +41,30 @@ private:
     bool showMiniMap;
     int activeMessage;
     std::string currentLevel;
+    std::string currentMap;  // Карта внутри WAD, пусто для PNG
+    std::string wadPath;     // WAD со списком карт в меню (--wad=)
     int windowWidth;
     int windowHeight;
 
+    // Симуляция с фиксированным шагом 1 / tickRate секунды
+    int tickRate;
+    int lastUpdateTime;    // мс, GLUT_ELAPSED_TIME
+    double accumulator;    // Накопленное, но ещё не просимулированное время, с
+    bool simulationActive;
+
+    // Фоновая загрузка уровня: декодирование и стены в потоке, загрузка в GL - в главном
+    std::thread loaderThread;
+    std::atomic<bool> loadingDone;
+    bool loadingSucceeded;
+    GameState stateBeforeLoading;
+    std::string loadingLevel;
+    std::string loadingMap;
+    std::vector<TextureManager::Image> loadingTextures;  // Текстуры уровня, которых ещё нет в кэше, декодированные в потоке
+
+    static void parseOptions(int argc, char** argv);
+    bool isSimulationNeeded() const;
+    void finishLevelLoad();
+    static void loadingTimerCallback(int);
     static void reshapeCallback(int w, int h);
     static void keyboardCallback(unsigned char key, int x, int y);
     static void keyboardUpCallback(unsigned char key, int x, int y);
@@ -18,17 +18,7 @@ void InputHandler::keyboard(unsigned char key, int x, int y, Game& game) {
     } else if (game.getState() == GameState::WIN && game.getActiveMessage() != -1) {
         if (key == 'y' || key == 'Y') {
             if (game.getActiveMessage() == 0) {  // Start again
-                std::string level = game.getCurrentLevel();
-                Maze::getInstance().loadFromImage("../LabyrinthProject/" + level);
-                if (!Maze::getInstance().getWalls().empty()) {
-                    Renderer::loadTexture("../LabyrinthProject/wall_texture.png", Renderer::wallTexture);
-                    Renderer::loadTexture("../LabyrinthProject/floor_texture.png", Renderer::floorTexture);
-                    game.setActiveMessage(-1);
-                    game.setMiniMapShown(false);
-                    Maze::getInstance().resetPlayerPosition();
-                    game.setState(GameState::PLAYING);
-                    glutPostRedisplay();
-                }
+                game.startLevel(game.getCurrentLevel(), game.getCurrentMap());
             } else if (game.getActiveMessage() == 1) {  // Exit
                 exit(0);
             } else if (game.getActiveMessage() == 2) {  // Go back to the menu
@@ -44,6 +34,16 @@ void InputHandler::keyboard(unsigned char key, int x, int y, Game& game) {
     }
 }
 
+bool InputHandler::isMovementKeyPressed() {
+    const char movementKeys[] = "wWsSaAdDqQeE";
+    for (const char* c = movementKeys; *c != '\0'; c++) {
+        if (keys[(unsigned char)*c]) {
+            return true;
+        }
+    }
+    return specialKeys[GLUT_KEY_UP] || specialKeys[GLUT_KEY_DOWN] || specialKeys[GLUT_KEY_LEFT] || specialKeys[GLUT_KEY_RIGHT];
+}
+
 void InputHandler::keyboardUp(unsigned char key, int x, int y) {
     keys[key] = false;
 }
@@ -69,34 +69,20 @@ void InputHandler::mouse(int button, int state, int x, int y, Game& game) {
             float menuXEnd = menuXStart + menuButtonWidth;
 
             if (x >= menuXStart && x <= menuXEnd && y >= 0.583f * windowHeight && y <= 0.666f * windowHeight) {  // Easy
-                Maze::getInstance().loadFromImage("../LabyrinthProject/maze_easy.png");
-                if (!Maze::getInstance().getWalls().empty()) {
-                    Renderer::loadTexture("../LabyrinthProject/wall_texture.png", Renderer::wallTexture);
-                    Renderer::loadTexture("../LabyrinthProject/floor_texture.png", Renderer::floorTexture);
-                    game.setState(GameState::PLAYING);
-                    game.setCurrentLevel("maze_easy.png");
-                    game.setMiniMapShown(false);
-                    glutPostRedisplay();
-                }
+                game.startLevel("../LabyrinthProject/maze_easy.png");
             } else if (x >= menuXStart && x <= menuXEnd && y >= 0.458f * windowHeight && y <= 0.541f * windowHeight) {  // Medium
-                Maze::getInstance().loadFromImage("../LabyrinthProject/maze_medium.png");
-                if (!Maze::getInstance().getWalls().empty()) {
-                    Renderer::loadTexture("../LabyrinthProject/wall_texture.png", Renderer::wallTexture);
-                    Renderer::loadTexture("../LabyrinthProject/floor_texture.png", Renderer::floorTexture);
-                    game.setState(GameState::PLAYING);
-                    game.setCurrentLevel("maze_medium.png");
-                    game.setMiniMapShown(false);
-                    glutPostRedisplay();
-                }
+                game.startLevel("../LabyrinthProject/maze_medium.png");
             } else if (x >= menuXStart && x <= menuXEnd && y >= 0.333f * windowHeight && y <= 0.416f * windowHeight) {  // Hard
-                Maze::getInstance().loadFromImage("../LabyrinthProject/maze_hard.png");
-                if (!Maze::getInstance().getWalls().empty()) {
-                    Renderer::loadTexture("../LabyrinthProject/wall_texture.png", Renderer::wallTexture);
-                    Renderer::loadTexture("../LabyrinthProject/floor_texture.png", Renderer::floorTexture);
-                    game.setState(GameState::PLAYING);
-                    game.setCurrentLevel("maze_hard.wad");
-                    game.setMiniMapShown(false);
-                    glutPostRedisplay();
+                game.startLevel("../LabyrinthProject/maze_hard.png");
+            } else {
+                const std::vector<WADFile::MapEntry>& maps = Maze::getInstance().getWADMaps();
+                for (size_t i = 0; i < maps.size(); i++) {
+                    float bx, by, bw, bh;
+                    Renderer::getMapButtonRect((int)i, bx, by, bw, bh);
+                    if (x >= bx && x <= bx + bw && y >= by && y <= by + bh) {
+                        game.startLevel(Maze::getInstance().getWADFilename(), maps[i].name);
+                        break;
+                    }
                 }
             }
         } else if (game.getState() == GameState::WIN) {
@@ -118,21 +104,7 @@ void InputHandler::mouse(int button, int state, int x, int y, Game& game) {
                 glutPostRedisplay();
             } else if (game.getActiveMessage() == 0) {
                 if (x >= 0.4375f * windowWidth && x <= 0.5f * windowWidth && y >= 0.533f * windowHeight && y <= 0.566f * windowHeight) {  // YES для Start again
-                    std::string level = game.getCurrentLevel();
-                    if (level.find(".wad") != std::string::npos) {
-                        Maze::getInstance().loadFromWAD("../LabyrinthProject/" + level);
-                    } else {
-                        Maze::getInstance().loadFromImage("../LabyrinthProject/" + level);
-                    }
-                    if (!Maze::getInstance().getWalls().empty()) {
-                        Renderer::loadTexture("../LabyrinthProject/wall_texture.png", Renderer::wallTexture);
-                        Renderer::loadTexture("../LabyrinthProject/floor_texture.png", Renderer::floorTexture);
-                        game.setActiveMessage(-1);
-                        game.setMiniMapShown(false);
-                        Maze::getInstance().resetPlayerPosition();
-                        game.setState(GameState::PLAYING);
-                        glutPostRedisplay();
-                    }
+                    game.startLevel(game.getCurrentLevel(), game.getCurrentMap());
                 } else if (x >= 0.5125f * windowWidth && x <= 0.575f * windowWidth && y >= 0.533f * windowHeight && y <= 0.566f * windowHeight) {  // NO
                     game.setActiveMessage(-1);
                     glutPostRedisplay();
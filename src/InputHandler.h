@@ -14,6 +14,7 @@ public:
 
     static bool isKeyPressed(int key) { return keys[key]; }
     static bool isSpecialKeyPressed(int key) { return specialKeys[key]; }
+    static bool isMovementKeyPressed();
 
 private:
     static bool keys[256];
@@ -0,0 +1,209 @@
+#include "LevelCache.h"
+#include "Maze.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include <filesystem>
+
+std::string LevelCache::directory = "level_cache";
+
+namespace {
+
+const char lmzMagic[4] = { 'L', 'M', 'Z', '1' };
+const uint32_t lmzVersion = 3;  // Увеличивать при любом изменении формата или загрузчиков
+
+// Все поля по 4 байта, выравнивание не добавляет промежутков
+struct LMZHeader {
+    char magic[4];
+    uint32_t version;
+    float width, height;
+    float startX, startZ;
+    float exitX, exitZ;
+    uint32_t wallFloats;
+    float gridOriginX, gridOriginZ, gridCellSize;
+    int32_t gridCols, gridRows;
+    uint32_t cellStartCount;
+    uint32_t cellBoxCount;
+    int32_t visibilityCols, visibilityRows;
+    float pvsRange;
+    uint32_t pvsWordCount;
+};
+
+uint64_t fnv1a(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}
+
+std::string LevelCache::cacheFile(const std::string& source, const std::string& mapName, const Maze& maze) {
+    MappedFile file;
+    if (!file.open(source)) {
+        return "";
+    }
+
+    uint64_t hash = fnv1a(file.data(), file.size());
+    hash = fnv1a((const unsigned char*)mapName.c_str(), mapName.size() + 1, hash);
+    // PVS считается по карте занятости, поэтому её разрешение тоже часть ключа
+    float resolution = maze.getOccupancyResolution();
+    uint32_t settings[3] = { lmzVersion, (uint32_t)maze.getWallExtraction(), 0 };
+    memcpy(&settings[2], &resolution, sizeof(float));
+    hash = fnv1a((const unsigned char*)settings, sizeof(settings), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.lmz", (unsigned long long)hash);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool LevelCache::load(const std::string& cacheFile, Maze& maze) {
+    MappedFile file;
+    if (!file.open(cacheFile) || file.size() < sizeof(LMZHeader)) {
+        return false;
+    }
+
+    LMZHeader header;
+    memcpy(&header, file.data(), sizeof(LMZHeader));
+    if (memcmp(header.magic, lmzMagic, 4) != 0 || header.version != lmzVersion) {
+        return false;
+    }
+
+    // Всё читается в локальные структуры и проверяется; Maze меняется, только если файл цел целиком.
+    // Индексы из файла потом идут в CollisionGrid и выборки WallBoxes без проверок границ
+    auto corrupted = [&]() {
+        printf("Повреждённый файл кэша уровня: %s\n", cacheFile.c_str());
+        return false;
+    };
+    int64_t gridCells = (int64_t)header.gridCols * header.gridRows;
+    size_t expectedSize = sizeof(LMZHeader) + (size_t)header.wallFloats * sizeof(float)
+        + ((size_t)header.cellStartCount + header.cellBoxCount) * sizeof(int32_t) + (size_t)header.pvsWordCount * sizeof(uint64_t);
+    if (header.wallFloats % 4 != 0 || file.size() != expectedSize || header.gridCols < 0 || header.gridRows < 0
+        || header.cellStartCount != (uint64_t)gridCells + (gridCells > 0 ? 1 : 0)
+        || (gridCells > 0 && !(header.gridCellSize > 0.0f)) || !(header.width > 0.0f && header.width < 1e6f)
+        || !(header.height > 0.0f && header.height < 1e6f)) {
+        return corrupted();
+    }
+
+    const unsigned char* data = file.data() + sizeof(LMZHeader);
+    std::vector<float> walls(header.wallFloats);
+    memcpy(walls.data(), data, header.wallFloats * sizeof(float));
+    data += header.wallFloats * sizeof(float);
+    // Загрузчики не выпускают стены дальше чем на толщину стены за край карты; иначе размеры сеток не ограничены
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        float limitX = header.width + 1.0f, limitZ = header.height + 1.0f;
+        if (!(std::fabs(walls[i]) <= limitX && std::fabs(walls[i + 1]) <= limitZ && walls[i + 2] >= 0.0f && walls[i + 2] <= 2.0f * limitX
+              && walls[i + 3] >= 0.0f && walls[i + 3] <= 2.0f * limitZ)) {
+            return corrupted();
+        }
+    }
+
+    CollisionGrid grid;
+    grid.originX = header.gridOriginX;
+    grid.originZ = header.gridOriginZ;
+    grid.cellSize = header.gridCellSize;
+    grid.cols = header.gridCols;
+    grid.rows = header.gridRows;
+    grid.cellStart.resize(header.cellStartCount);
+    memcpy(grid.cellStart.data(), data, header.cellStartCount * sizeof(int32_t));
+    data += header.cellStartCount * sizeof(int32_t);
+    grid.cellBoxes.resize(header.cellBoxCount);
+    memcpy(grid.cellBoxes.data(), data, header.cellBoxCount * sizeof(int32_t));
+    data += header.cellBoxCount * sizeof(int32_t);
+    // Диапазоны ячеек идут подряд от 0 до конца cellBoxes, номера боксов - в пределах стен
+    if (!grid.cellStart.empty() && (grid.cellStart.front() != 0 || (uint32_t)grid.cellStart.back() != header.cellBoxCount)) {
+        return corrupted();
+    }
+    for (size_t cell = 0; cell + 1 < grid.cellStart.size(); cell++) {
+        if (grid.cellStart[cell + 1] < grid.cellStart[cell]) {
+            return corrupted();
+        }
+    }
+    int wallCount = (int)(walls.size() / 4);
+    for (int box : grid.cellBoxes) {
+        if (box < 0 || box >= wallCount) {
+            return corrupted();
+        }
+    }
+
+    // Сетка видимости строится из стен; сохранённый PVS должен ей соответствовать
+    VisibilityGrid visibility;
+    visibility.build(walls, header.width, header.height);
+    if (visibility.cols != header.visibilityCols || visibility.rows != header.visibilityRows
+        || header.pvsWordCount != (uint64_t)visibility.cols * visibility.rows * visibility.words) {
+        return corrupted();
+    }
+    visibility.range = header.pvsRange;
+    visibility.pvs.resize(header.pvsWordCount);
+    memcpy(visibility.pvs.data(), data, header.pvsWordCount * sizeof(uint64_t));
+
+    maze.walls.swap(walls);
+    maze.collisionGrid = std::move(grid);
+    maze.width = header.width;
+    maze.height = header.height;
+    maze.startX = header.startX;
+    maze.startZ = header.startZ;
+    maze.exitX = header.exitX;
+    maze.exitZ = header.exitZ;
+    // Производные структуры не хранятся: они строятся из стен быстрее, чем читаются. Кроме PVS
+    maze.buildQueryStructures();
+    maze.visibilityGrid = std::move(visibility);
+    return true;
+}
+
+bool LevelCache::save(const std::string& cacheFile, const Maze& maze) {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(cacheFile).parent_path(), error);
+
+    // Пишем во временный файл и переименовываем, чтобы не оставить обрезанный кэш
+    std::string tempFile = cacheFile + ".tmp";
+    FILE* file = fopen(tempFile.c_str(), "wb");
+    if (!file) {
+        printf("Не удалось записать кэш уровня: %s\n", cacheFile.c_str());
+        return false;
+    }
+
+    const CollisionGrid& grid = maze.collisionGrid;
+    LMZHeader header;
+    memcpy(header.magic, lmzMagic, 4);
+    header.version = lmzVersion;
+    header.width = maze.width;
+    header.height = maze.height;
+    header.startX = maze.startX;
+    header.startZ = maze.startZ;
+    header.exitX = maze.exitX;
+    header.exitZ = maze.exitZ;
+    header.wallFloats = (uint32_t)maze.walls.size();
+    header.gridOriginX = grid.originX;
+    header.gridOriginZ = grid.originZ;
+    header.gridCellSize = grid.cellSize;
+    header.gridCols = grid.cols;
+    header.gridRows = grid.rows;
+    header.cellStartCount = (uint32_t)grid.cellStart.size();
+    header.cellBoxCount = (uint32_t)grid.cellBoxes.size();
+    const VisibilityGrid& visibility = maze.visibilityGrid;
+    header.visibilityCols = visibility.cols;
+    header.visibilityRows = visibility.rows;
+    header.pvsRange = visibility.range;
+    header.pvsWordCount = (uint32_t)visibility.pvs.size();
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(maze.walls.data(), sizeof(float), maze.walls.size(), file) == maze.walls.size()
+        && fwrite(grid.cellStart.data(), sizeof(int32_t), grid.cellStart.size(), file) == grid.cellStart.size()
+        && fwrite(grid.cellBoxes.data(), sizeof(int32_t), grid.cellBoxes.size(), file) == grid.cellBoxes.size()
+        && fwrite(visibility.pvs.data(), sizeof(uint64_t), visibility.pvs.size(), file) == visibility.pvs.size();
+    ok = fclose(file) == 0 && ok;
+    if (ok) {
+        std::filesystem::rename(tempFile, cacheFile, error);
+        ok = !error;
+    }
+    if (!ok) {
+        std::filesystem::remove(tempFile, error);
+        printf("Не удалось записать кэш уровня: %s\n", cacheFile.c_str());
+    }
+    return ok;
+}
@@ -0,0 +1,24 @@
+#ifndef LEVEL_CACHE_H
+#define LEVEL_CACHE_H
+
+#include <string>
+
+class Maze;
+
+// Скомпилированные уровни (.lmz): боксы стен, старт, выход, сетка коллизий и PVS.
+// Файл кэша называется по хешу содержимого исходного PNG/WAD, имени карты и настроек загрузки
+class LevelCache {
+public:
+    static void setDirectory(const std::string& dir) { directory = dir; }
+    static const std::string& getDirectory() { return directory; }
+
+    // Путь к файлу кэша для исходника; пустая строка, если исходник не читается
+    static std::string cacheFile(const std::string& source, const std::string& mapName, const Maze& maze);
+    static bool load(const std::string& cacheFile, Maze& maze);
+    static bool save(const std::string& cacheFile, const Maze& maze);
+
+private:
+    static std::string directory;
+};
+
+#endif
@@ -1,60 +1,87 @@
 #include "Maze.h"
 #include "Renderer.h"
 #include "Player.h"
+#include "LevelCache.h"
+#include "WallExtractor.h"
+#include "PixelClassifier.h"
+#include "Parallel.h"
+#include "PNGRowReader.h"
 #include <cmath>
-#include <fstream>
 #include <vector>
 #include <cstring>
+#include <cctype>
+#include <map>
+#include <algorithm>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "C:\LabyrinthProject\include\stb_image.h"
 
-// Структуры для WAD-формата
-struct WADHeader {
-    char magic[4]; // "IWAD" или "PWAD"
-    int numLumps;
-    int directoryOffset;
-};
-
-struct WADLump {
-    int offset;
-    int size;
-    char name[8];
-};
-
-struct WADVertex {
-    short x, y;
-};
-
-struct WADLineDef {
-    short startVertex;
-    short endVertex;
-    short flags;
-    short specialType;
-    short sectorTag;
-    short rightSideDef;
-    short leftSideDef;
-};
-
-struct WADThing {
-    short x, y;
-    short angle;
-    short type;
-    short flags;
-};
-
-Maze::Maze() : width(20.0f), height(20.0f), exitX(0.0f), exitZ(0.0f), startX(0.0f), startZ(0.0f) {}
-
-void Maze::loadFromImage(const std::string& filename) {
-    int width, height, channels;
-    unsigned char* image = stbi_load(filename.c_str(), &width, &height, &channels, 3);
+namespace {
+
+// Расширение .wad в любом регистре: стандартные IWAD называются DOOM.WAD, DOOM2.WAD
+bool isWADPath(const std::string& path) {
+    const char* extension = ".wad";
+    size_t length = strlen(extension);
+    if (path.size() < length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (std::tolower((unsigned char)path[path.size() - length + i]) != extension[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+Maze::Maze() : width(20.0f), height(20.0f), exitX(0.0f), exitZ(0.0f), startX(0.0f), startZ(0.0f), occupancyResolution(8.0f), wallExtraction(WallExtraction::RECTANGLES), loadProgress(0.0f) {}
+
+bool Maze::loadLevel(const std::string& path, const std::string& mapName) {
+    std::string cacheFile = LevelCache::cacheFile(path, mapName, *this);
+    if (!cacheFile.empty() && LevelCache::load(cacheFile, *this)) {
+        resetPlayerPosition();
+        loadProgress = 1.0f;
+        return !walls.empty();
+    }
+
+    // Неудачная загрузка может не тронуть стены прошлого уровня: их нельзя ни считать новым уровнем, ни класть в кэш
+    bool loaded = isWADPath(path) ? loadFromWAD(path, mapName) : loadFromImage(path);
+    if (!loaded || walls.empty()) {
+        return false;
+    }
+    loadProgress = 0.9f;
+    visibilityGrid.buildPVS(walls, occupancyGrid, visibilityRange);
+    if (!cacheFile.empty()) {
+        LevelCache::save(cacheFile, *this);
+    }
+    loadProgress = 1.0f;
+    return true;
+}
 
-    if (!image) {
-        printf("Ошибка загрузки изображения: %s\n", filename.c_str());
-        return;
+bool Maze::loadFromImage(const std::string& filename) {
+    // PNG без чересстрочности читается построчно, остальное - целиком через stb_image
+    PNGRowReader png;
+    bool streaming = png.open(filename);
+    int width, height, channels;
+    unsigned char* image = nullptr;
+    if (streaming) {
+        width = png.getWidth();
+        height = png.getHeight();
+    } else {
+        image = stbi_load(filename.c_str(), &width, &height, &channels, 3);
+        if (!image) {
+            printf("Ошибка загрузки изображения: %s\n", filename.c_str());
+            return false;
+        }
     }
 
     walls.clear();
+    collisionGrid.clear();
+    wallBoxes.clear();
+    occupancyGrid.clear();
+    distanceField.clear();
+    loadProgress = 0.1f;
 
     float aspectRatio = (float)width / height;
     this->width = 20.0f;
@@ -63,16 +90,138 @@ void Maze::loadFromImage(const std::string& filename) {
     float scaleZ = this->height / height;
     float wallThickness = 0.5f;
 
-    // Установка начальной позиции игрока
-    bool startFound = false;
-    int startXPixel = 0;
-    for (int x = 0; x < width && !startFound; x++) {
-        int index = ((height - 1) * width + x) * 3; // Нижняя строка
-        if (image[index] == 255 && image[index + 1] == 255 && image[index + 2] == 255) {
-            startXPixel = x;
-            startFound = true;
+    // Генерация стен: строки сразу переводятся в биты и копятся в окне; окно делится
+    // на полосы, которые обрабатываются параллельно и сшиваются между собой и с предыдущим окном.
+    // Слияние строк корректно, только пока соседние полосы толщиной wallThickness перекрываются
+    bool mergeRows = wallExtraction == WallExtraction::RECTANGLES && scaleZ <= wallThickness;
+
+    int words = PixelClassifier::wordsForWidth(width);
+    int bands = parallelBandCount(height);
+    int windowRows = std::min(height, bands * 128);
+    std::vector<uint64_t> window((size_t)windowRows * words);
+    int windowBegin = 0;
+    int windowFilled = 0;
+
+    // Последняя полоса окна не закрывается: её открытые прямоугольники продолжает
+    // первая полоса следующего окна, так что окна не добавляют лишних швов
+    WallExtractor carry(width, mergeRows);
+    std::vector<std::vector<PixelRect>> bandRects(bands);
+    std::map<std::pair<int, int>, PixelRect> seamRects;
+    size_t rowRunCount = 0;
+
+    auto emitWall = [&](const PixelRect& rect) {
+        walls.push_back((rect.x * scaleX) - (this->width / 2));
+        walls.push_back((rect.y * scaleZ) - (this->height / 2));
+        walls.push_back(rect.width * scaleX);
+        walls.push_back((rect.rows - 1) * scaleZ + wallThickness);
+    };
+
+    auto processWindow = [&]() {
+        int rows = windowFilled;
+        int windowBands = std::min(bands, rows);
+        std::vector<WallExtractor> extractors(windowBands, WallExtractor(width, mergeRows));
+        extractors[0] = std::move(carry);
+        parallelBands(rows, windowBands, [&](int band, int rowBegin, int rowEnd) {
+            WallExtractor& extractor = extractors[band];
+            for (int y = rowBegin; y < rowEnd; y++) {
+                extractor.addRow(window.data() + (size_t)y * words, windowBegin + y);
+            }
+            if (band < windowBands - 1) {
+                extractor.finish();
+            }
+            bandRects[band].swap(extractor.getRects());
+        });
+
+        // Прямоугольник, упёршийся в нижнюю границу полосы, продолжается прямоугольником
+        // следующей полосы с тем же отрезком, начинающимся на её первой строке.
+        // Сшиваются только совпадающие (x, ширина): если отрезок в следующей полосе шире,
+        // последовательный проход продлил бы верхний прямоугольник и начал новые по бокам,
+        // а здесь остаются оба целиком. Покрытие то же, но боксов может быть больше, чем
+        // при последовательном выделении, и их число зависит от числа полос
+        for (int band = 0; band < windowBands; band++) {
+            int rowBegin = windowBegin + (int)((long long)rows * band / windowBands);
+            int rowEnd = windowBegin + (int)((long long)rows * (band + 1) / windowBands);
+            std::map<std::pair<int, int>, PixelRect> nextSeamRects;
+            for (PixelRect rect : bandRects[band]) {
+                auto above = seamRects.find({ rect.x, rect.width });
+                if (mergeRows && rect.y == rowBegin && above != seamRects.end()) {
+                    rect.y = above->second.y;
+                    rect.rows += above->second.rows;
+                    seamRects.erase(above);
+                }
+                if (mergeRows && rect.y + rect.rows == rowEnd) {
+                    nextSeamRects[{ rect.x, rect.width }] = rect;
+                } else {
+                    emitWall(rect);
+                }
+            }
+            for (const auto& seamRect : seamRects) {
+                emitWall(seamRect.second);
+            }
+            seamRects.swap(nextSeamRects);
+            if (band < windowBands - 1) {
+                rowRunCount += extractors[band].getRowRunCount();
+            }
+            bandRects[band].clear();
+        }
+        carry = std::move(extractors[windowBands - 1]);
+
+        windowBegin += rows;
+        windowFilled = 0;
+        loadProgress = 0.1f + 0.8f * windowBegin / height;
+    };
+
+    // Старт ищется в нижней строке, выход - в верхней
+    bool startFound = false, exitFound = false;
+    int startXPixel = 0, exitXPixel = 0;
+    auto isWhite = [](const unsigned char* pixel) {
+        return pixel[0] == 255 && pixel[1] == 255 && pixel[2] == 255;
+    };
+    auto onRow = [&](const unsigned char* rgb, int y) {
+        if (y == height - 1) {
+            for (int x = 0; x < width && !startFound; x++) {
+                if (isWhite(rgb + x * 3)) {
+                    startXPixel = x;
+                    startFound = true;
+                }
+            }
+        }
+        if (y == 0) {
+            for (int x = width - 1; x >= 0 && !exitFound; x--) {
+                if (isWhite(rgb + x * 3)) {
+                    exitXPixel = x;
+                    exitFound = true;
+                }
+            }
         }
+        PixelClassifier::classifyRow(rgb, width, window.data() + (size_t)windowFilled * words);
+        if (++windowFilled == windowRows) {
+            processWindow();
+        }
+    };
+
+    if (streaming) {
+        if (!png.readRows(onRow)) {
+            printf("Ошибка распаковки PNG: %s\n", filename.c_str());
+            walls.clear();
+            return false;
+        }
+    } else {
+        for (int y = 0; y < height; y++) {
+            onRow(image + (size_t)y * width * 3, y);
+        }
+        stbi_image_free(image);
+    }
+    if (windowFilled > 0) {
+        processWindow();
     }
+    carry.finish();
+    for (const PixelRect& rect : carry.getRects()) {
+        emitWall(rect);
+    }
+    rowRunCount += carry.getRowRunCount();
+
+    // Установка начальной позиции игрока
     if (startFound) {
         int shiftedX = startXPixel + 2;
         if (shiftedX >= width) shiftedX = width - 1;
@@ -90,15 +239,6 @@ void Maze::loadFromImage(const std::string& filename) {
     }
 
     // Установка позиции выхода
-    bool exitFound = false;
-    int exitXPixel = 0;
-    for (int x = width - 1; x >= 0 && !exitFound; x--) {
-        int index = x * 3; // Верхняя строка
-        if (image[index] == 255 && image[index + 1] == 255 && image[index + 2] == 255) {
-            exitXPixel = x;
-            exitFound = true;
-        }
-    }
     if (exitFound) {
         int shiftedX = exitXPixel - 2;
         if (shiftedX < 0) shiftedX = 0;
@@ -109,95 +249,59 @@ void Maze::loadFromImage(const std::string& filename) {
         exitZ = -(this->height / 2) + 1.0f;
     }
 
-    // Генерация стен
-    std::vector<bool> visited(width * height, false);
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int index = (y * width + x) * 3;
-            if (!visited[y * width + x] && image[index] == 0 && image[index + 1] == 0 && image[index + 2] == 0) {
-                int wallWidth = 1;
-                for (int wx = x + 1; wx < width; wx++) {
-                    int wIndex = (y * width + wx) * 3;
-                    if (image[wIndex] == 0 && image[wIndex + 1] == 0 && image[wIndex + 2] == 0) {
-                        wallWidth++;
-                        visited[y * width + wx] = true;
-                    } else {
-                        break;
-                    }
-                }
-
-                float x1 = (x * scaleX) - (this->width / 2);
-                float z1 = (y * scaleZ) - (this->height / 2);
-                float wallLength = wallWidth * scaleX;
+    printf("Стены: %zu боксов по строкам, %zu после объединения\n", rowRunCount, walls.size() / 4);
+    collisionGrid.build(walls, this->width, this->height);
+    buildQueryStructures();
+    return true;
+}
 
-                walls.push_back(x1);
-                walls.push_back(z1);
-                walls.push_back(wallLength);
-                walls.push_back(wallThickness);
-            }
-        }
+bool Maze::openWAD(const std::string& filename) {
+    // Директория и индекс карт строятся один раз, пока грузятся уровни из того же файла
+    if (wadFile.isOpen() && wadFile.getFilename() == filename) {
+        return true;
     }
-
-    stbi_image_free(image);
+    return wadFile.open(filename);
 }
 
-void Maze::loadFromWAD(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        printf("Ошибка загрузки WAD: %s\n", filename.c_str());
-        return;
+bool Maze::loadFromWAD(const std::string& filename, const std::string& mapName) {
+    if (!openWAD(filename)) {
+        return false;
     }
 
     walls.clear();
-
-    // Чтение заголовка WAD
-    WADHeader header;
-    file.read((char*)&header, sizeof(WADHeader));
-    if (strncmp(header.magic, "IWAD", 4) != 0 && strncmp(header.magic, "PWAD", 4) != 0) {
-        printf("Неверный формат WAD-файла\n");
-        file.close();
-        return;
+    collisionGrid.clear();
+    wallBoxes.clear();
+    occupancyGrid.clear();
+    distanceField.clear();
+
+    // Читаются только лампы выбранной карты
+    const WADFile::MapEntry* map = nullptr;
+    if (mapName.empty()) {
+        map = wadFile.getMaps().empty() ? nullptr : &wadFile.getMaps().front();
+    } else {
+        map = wadFile.findMap(mapName);
     }
-
-    // Чтение директории
-    file.seekg(header.directoryOffset);
-    std::vector<WADLump> lumps(header.numLumps);
-    for (int i = 0; i < header.numLumps; i++) {
-        file.read((char*)&lumps[i], sizeof(WADLump));
+    if (!map) {
+        printf("Карта %s не найдена в %s\n", mapName.empty() ? "(первая)" : mapName.c_str(), filename.c_str());
+        return false;
     }
-
-    // Поиск лампов карты
-    int vertexesOffset = -1, vertexesSize = 0;
-    int linedefsOffset = -1, linedefsSize = 0;
-    int thingsOffset = -1, thingsSize = 0;
-    for (const auto& lump : lumps) {
-        char name[9] = {0};
-        strncpy(name, lump.name, 8);
-        if (strcmp(name, "VERTEXES") == 0) {
-            vertexesOffset = lump.offset;
-            vertexesSize = lump.size;
-        } else if (strcmp(name, "LINEDEFS") == 0) {
-            linedefsOffset = lump.offset;
-            linedefsSize = lump.size;
-        } else if (strcmp(name, "THINGS") == 0) {
-            thingsOffset = lump.offset;
-            thingsSize = lump.size;
-        }
+    if (map->vertexes == -1 || map->linedefs == -1) {
+        printf("Не найдены необходимые данные карты\n");
+        return false;
     }
 
-    if (vertexesOffset == -1 || linedefsOffset == -1) {
+    loadProgress = 0.1f;
+    LumpSpan<WADVertex> vertices = wadFile.view<WADVertex>(map->vertexes);
+    LumpSpan<WADLineDef> linedefs = wadFile.view<WADLineDef>(map->linedefs);
+    LumpSpan<WADThing> things;
+    if (map->things != -1) {
+        things = wadFile.view<WADThing>(map->things);
+    }
+    if (vertices.empty()) {
         printf("Не найдены необходимые данные карты\n");
-        file.close();
-        return;
+        return false;
     }
 
-    // Чтение вершин
-    std::vector<WADVertex> vertices;
-    file.seekg(vertexesOffset);
-    int numVertices = vertexesSize / sizeof(WADVertex);
-    vertices.resize(numVertices);
-    file.read((char*)vertices.data(), vertexesSize);
-
     // Определение границ карты для масштабирования
     float minX = vertices[0].x, maxX = vertices[0].x;
     float minY = vertices[0].y, maxY = vertices[0].y;
@@ -214,15 +318,15 @@ void Maze::loadFromWAD(const std::string& filename) {
     float scaleX = this->width / mapWidth;
     float scaleZ = this->height / mapHeight;
 
-    // Чтение линий (стен)
-    file.seekg(linedefsOffset);
-    int numLinedefs = linedefsSize / sizeof(WADLineDef);
-    std::vector<WADLineDef> linedefs(numLinedefs);
-    file.read((char*)linedefs.data(), linedefsSize);
-
+    // Линии (стены)
     float wallThickness = 0.5f;
     int filteredWalls = 0;
     for (const auto& linedef : linedefs) {
+        if (linedef.startVertex < 0 || (size_t)linedef.startVertex >= vertices.size()
+            || linedef.endVertex < 0 || (size_t)linedef.endVertex >= vertices.size()) {
+            filteredWalls++;
+            continue;
+        }
         if (linedef.rightSideDef != -1) { // Линия с одной или двумя сторонами (стена)
             float x1 = vertices[linedef.startVertex].x;
             float z1 = vertices[linedef.startVertex].y;
@@ -262,35 +366,32 @@ void Maze::loadFromWAD(const std::string& filename) {
         }
     }
 
+    collisionGrid.build(walls, this->width, this->height);
+    buildQueryStructures();
+    loadProgress = 0.5f;
+
     // Чтение объектов (начальная позиция и выход)
     bool startFound = false, exitFound = false;
-    if (thingsOffset != -1) {
-        file.seekg(thingsOffset);
-        int numThings = thingsSize / sizeof(WADThing);
-        std::vector<WADThing> things(numThings);
-        file.read((char*)things.data(), thingsSize);
-
-        for (const auto& thing : things) {
-            if (thing.type == 1) { // Player 1 start
-                this->startX = (thing.x - minX) * scaleX - (this->width / 2);
-                this->startZ = (maxY - thing.y) * scaleZ - (this->height / 2);
-                if (!findSafePlayerPosition(this->startX, this->startZ, false, 1.0f)) {
-                    printf("Warning: Could not find safe player position near Thing, trying exhaustive search\n");
-                    if (!findSafePlayerPosition(this->startX, this->startZ, true, 1.0f)) {
-                        printf("Warning: Could not find safe player position, using default\n");
-                        this->startX = -this->width / 2 + 1.0f;
-                        this->startZ = this->height / 2 - 1.0f;
-                    }
+    for (const auto& thing : things) {
+        if (thing.type == 1) { // Player 1 start
+            this->startX = (thing.x - minX) * scaleX - (this->width / 2);
+            this->startZ = (maxY - thing.y) * scaleZ - (this->height / 2);
+            if (!findSafePlayerPosition(this->startX, this->startZ, false, 1.0f)) {
+                printf("Warning: Could not find safe player position near Thing, trying exhaustive search\n");
+                if (!findSafePlayerPosition(this->startX, this->startZ, true, 1.0f)) {
+                    printf("Warning: Could not find safe player position, using default\n");
+                    this->startX = -this->width / 2 + 1.0f;
+                    this->startZ = this->height / 2 - 1.0f;
                 }
-                Player::setX(this->startX);
-                Player::setZ(this->startZ);
-                Player::setAngle(M_PI);
-                startFound = true;
-            } else if (thing.type == 11) { // Exit (пример)
-                this->exitX = (thing.x - minX) * scaleX - (this->width / 2);
-                this->exitZ = (maxY - thing.y) * scaleZ - (this->height / 2);
-                exitFound = true;
             }
+            Player::setX(this->startX);
+            Player::setZ(this->startZ);
+            Player::setAngle(M_PI);
+            startFound = true;
+        } else if (thing.type == 11) { // Exit (пример)
+            this->exitX = (thing.x - minX) * scaleX - (this->width / 2);
+            this->exitZ = (maxY - thing.y) * scaleZ - (this->height / 2);
+            exitFound = true;
         }
     }
 
@@ -313,31 +414,23 @@ void Maze::loadFromWAD(const std::string& filename) {
     }
 
     // Проверка начальной позиции на коллизию
-    for (size_t i = 0; i < walls.size(); i += 4) {
-        if (Player::checkCollision(this->startX, this->startZ, walls[i], walls[i + 1], walls[i + 2], walls[i + 3])) {
-            printf("Warning: Player start position is inside wall at x=%.2f, z=%.2f\n", walls[i], walls[i + 1]);
-        }
+    if (isPositionBlocked(this->startX, this->startZ, Player::radius)) {
+        printf("Warning: Player start position x=%.2f, z=%.2f is inside a wall\n", this->startX, this->startZ);
     }
+    return true;
+}
 
-    file.close();
+void Maze::buildQueryStructures() {
+    wallBoxes.build(walls, Player::radius);
+    occupancyGrid.build(walls, width, height, occupancyResolution);
+    distanceField.build(occupancyGrid);
+    visibilityGrid.build(walls, width, height);
 }
 
 bool Maze::findSafePlayerPosition(float& x, float& z, bool exhaustiveSearch, float minClearRadius) {
+    // Каждая проверка - поиск в карте расстояний, а не перебор стен
     auto isPositionClear = [&](float testX, float testZ) {
-        for (size_t i = 0; i < walls.size(); i += 4) {
-            // Проверяем, чтобы точка не была в стене
-            if (Player::checkCollision(testX, testZ, walls[i], walls[i + 1], walls[i + 2], walls[i + 3])) {
-                return false;
-            }
-            // Проверяем, чтобы в радиусе minClearRadius не было стен
-            float dx = std::max(0.0f, std::max(walls[i] - testX, testX - (walls[i] + walls[i + 2])));
-            float dz = std::max(0.0f, std::max(walls[i + 1] - testZ, testZ - (walls[i + 1] + walls[i + 3])));
-            float distance = sqrt(dx * dx + dz * dz);
-            if (distance < minClearRadius) {
-                return false;
-            }
-        }
-        return true;
+        return hasClearance(testX, testZ, minClearRadius) && !isPositionBlocked(testX, testZ, Player::radius);
     };
 
     if (!exhaustiveSearch) {
@@ -372,6 +465,63 @@ bool Maze::findSafePlayerPosition(float& x, float& z, bool exhaustiveSearch, flo
     }
 }
 
+// Номера боксов-кандидатов из сетки; буфер свой у каждого потока и переиспользуется
+static std::vector<int>& queryCandidates(const CollisionGrid& grid, float minX, float minZ, float maxX, float maxZ) {
+    thread_local std::vector<int> candidates;
+    candidates.clear();
+    grid.collect(minX, minZ, maxX, maxZ, candidates);
+    return candidates;
+}
+
+bool Maze::hasClearance(float x, float z, float radius) const {
+    if (distanceField.getLowerBound(x, z) >= radius) {
+        return true;
+    }
+    if (distanceField.getUpperBound(x, z) < radius) {
+        return false;
+    }
+    // Оценки не различают - расстояние до боксов поблизости считается точно
+    std::vector<int>& candidates = queryCandidates(collisionGrid, x - radius, z - radius, x + radius, z + radius);
+    return !wallBoxes.anyCloserThan(candidates.data(), (int)candidates.size(), x, z, radius);
+}
+
+bool Maze::isPositionBlocked(float x, float z, float radius) const {
+    if (!occupancyGrid.isAreaBlocked(x - radius, z - radius, x + radius, z + radius)) {
+        return false;
+    }
+    std::vector<int>& candidates = queryCandidates(collisionGrid, x - radius, z - radius, x + radius, z + radius);
+    return wallBoxes.anyContains(candidates.data(), (int)candidates.size(), x, z, radius);
+}
+
+float Maze::sweep(float x, float z, float dx, float dz, float radius) const {
+    // Луч из (x, z) против боксов, расширенных на radius (метод плит).
+    // Проверяется весь отрезок, поэтому быстрое движение не проскакивает сквозь тонкие стены
+    float minX = std::min(x, x + dx) - radius, maxX = std::max(x, x + dx) + radius;
+    float minZ = std::min(z, z + dz) - radius, maxZ = std::max(z, z + dz) + radius;
+    std::vector<int>& candidates = queryCandidates(collisionGrid, minX, minZ, maxX, maxZ);
+    return wallBoxes.sweep(candidates.data(), (int)candidates.size(), x, z, dx, dz, radius);
+}
+
+void Maze::moveAndSlide(float& x, float& z, float dx, float dz, float radius) const {
+    // Останавливаемся чуть раньше касания, иначе следующая проверка сочтёт точку внутри стены
+    const float skin = 1e-4f;
+    auto moveAxis = [&](float& coord, float delta, float time) {
+        if (time >= 1.0f) {
+            coord += delta;
+        } else {
+            float distance = std::max(0.0f, std::fabs(delta) * time - skin);
+            coord += delta > 0.0f ? distance : -distance;
+        }
+    };
+
+    if (dx != 0.0f) {
+        moveAxis(x, dx, sweep(x, z, dx, 0.0f, radius));
+    }
+    if (dz != 0.0f) {
+        moveAxis(z, dz, sweep(x, z, 0.0f, dz, radius));
+    }
+}
+
 void Maze::resetPlayerPosition() {
     Player::setX(this->startX);
     Player::setZ(this->startZ);
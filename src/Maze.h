@@ -3,22 +3,74 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
+#include "CollisionGrid.h"
+#include "OccupancyGrid.h"
+#include "DistanceField.h"
+#include "WallBoxes.h"
+#include "VisibilityGrid.h"
+#include "WADFile.h"
 
 // Задание: создать класс Loader. От него 2 функции для PNG и WAD файлов
 
+// Способ выделения стен из PNG: отрезки по строкам или прямоугольники, объединённые по строкам
+enum class WallExtraction { ROW_RUNS, RECTANGLES };
+
 class Maze {
 public:
+    // Глубина в кадре, дальше которой стены скрыты туманом
+    static constexpr float viewDistance = 15.0f;
+    // Радиус PVS. Туман считается по глубине, а не по расстоянию: у края кадра с 45° по вертикали
+    // и соотношением сторон до 2.5:1 точка на глубине viewDistance дальше не больше чем в 1.5 раза
+    static constexpr float visibilityRange = viewDistance * 1.5f;
+
     Maze();
-    void loadFromImage(const std::string& filename);
-    void loadFromWAD(const std::string& filename);
+    // Загрузка PNG или карты WAD через кэш скомпилированных уровней (LevelCache)
+    bool loadLevel(const std::string& path, const std::string& mapName = "");
+    // false - файл не прочитан; стены тогда могут остаться от прошлого уровня
+    bool loadFromImage(const std::string& filename);
+    // mapName - маркер карты (E1M1, MAP01, ...); пустое имя - первая карта файла
+    bool loadFromWAD(const std::string& filename, const std::string& mapName = "");
+    bool openWAD(const std::string& filename);
     void resetPlayerPosition();
     bool findSafePlayerPosition(float& x, float& z, bool exhaustiveSearch = false, float minClearRadius = 1.0f); // Добавлен minClearRadius
 
+    // Запросы коллизий для круга радиуса radius (игрок, а также любые другие агенты).
+    // Стена задевает точку, если та лежит в её боксе, расширенном на radius
+    bool isPositionBlocked(float x, float z, float radius) const;
+    // Доля пути (dx, dz) от 0 до 1, пройденная до первого касания стены
+    float sweep(float x, float z, float dx, float dz, float radius) const;
+    // Перемещение с раздельным разрешением по X и Z: упёршись в стену, скользим вдоль неё
+    void moveAndSlide(float& x, float& z, float dx, float dz, float radius) const;
+    // Есть ли стена в точке - по битовой карте занятости, с точностью до её ячейки
+    bool isBlocked(float x, float z) const { return occupancyGrid.isBlocked(x, z); }
+    // Нет ли стен ближе radius к точке: по карте расстояний, точная проверка - только у границы
+    bool hasClearance(float x, float z, float radius) const;
+    // Расстояние до ближайшей стены с запасом вниз (не больше точного)
+    float getClearance(float x, float z) const { return distanceField.getLowerBound(x, z); }
+
     float getWidth() const { return width; }
     float getHeight() const { return height; }
     float getExitX() const { return exitX; }
     float getExitZ() const { return exitZ; }
     const std::vector<float>& getWalls() const { return walls; }
+    // Те же стены раздельными массивами границ для пакетных проверок
+    const WallBoxes& getWallBoxes() const { return wallBoxes; }
+    const CollisionGrid& getCollisionGrid() const { return collisionGrid; }
+    const OccupancyGrid& getOccupancyGrid() const { return occupancyGrid; }
+    const DistanceField& getDistanceField() const { return distanceField; }
+    // Ячейки-кластеры стен и наборы видимых из каждой ячейки (PVS)
+    const VisibilityGrid& getVisibilityGrid() const { return visibilityGrid; }
+    float getOccupancyResolution() const { return occupancyResolution; }
+    // Ячеек битовой карты на единицу длины; применяется при следующей загрузке уровня
+    void setOccupancyResolution(float cellsPerUnit) { occupancyResolution = cellsPerUnit; }
+    const std::vector<WADFile::MapEntry>& getWADMaps() const { return wadFile.getMaps(); }
+    const std::string& getWADFilename() const { return wadFile.getFilename(); }
+    WallExtraction getWallExtraction() const { return wallExtraction; }
+    // Доля выполненной загрузки (0..1), читается из главного потока во время LOADING
+    float getLoadProgress() const { return loadProgress; }
+    void setLoadProgress(float progress) { loadProgress = progress; }
+    void setWallExtraction(WallExtraction mode) { wallExtraction = mode; }
 
     static Maze& getInstance() {
         static Maze instance;
@@ -26,11 +78,26 @@ public:
     }
 
 private:
+    friend class LevelCache;
+
+    // Массивы границ, битовая карта занятости, карта расстояний и сетка видимости по текущим стенам.
+    // PVS сюда не входит: он дорогой и хранится в кэше уровня
+    void buildQueryStructures();
+
     float width;
     float height;
     float exitX, exitZ;
     float startX, startZ;
     std::vector<float> walls;
+    WallBoxes wallBoxes;
+    CollisionGrid collisionGrid;
+    OccupancyGrid occupancyGrid;
+    DistanceField distanceField;
+    VisibilityGrid visibilityGrid;
+    float occupancyResolution;
+    WADFile wadFile;
+    WallExtraction wallExtraction;
+    std::atomic<float> loadProgress;
 };
 
 #endif
\ No newline at end of file
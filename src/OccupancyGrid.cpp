@@ -0,0 +1,101 @@
+#include "OccupancyGrid.h"
+#include "BitRow.h"
+#include <algorithm>
+#include <cmath>
+
+OccupancyGrid::OccupancyGrid() : originX(0.0f), originZ(0.0f), cellSize(1.0f), cols(0), rows(0), words(0) {}
+
+void OccupancyGrid::clear() {
+    cols = 0;
+    rows = 0;
+    words = 0;
+    bits.clear();
+}
+
+int OccupancyGrid::cellCol(float x) const {
+    return (int)std::floor((x - originX) / cellSize);
+}
+
+int OccupancyGrid::cellRow(float z) const {
+    return (int)std::floor((z - originZ) / cellSize);
+}
+
+void OccupancyGrid::build(const std::vector<float>& walls, float mapWidth, float mapHeight, float cellsPerUnit) {
+    clear();
+    if (walls.empty() || cellsPerUnit <= 0.0f) {
+        return;
+    }
+
+    // Границы те же, что у CollisionGrid: карта плюс стены, выходящие за неё
+    float minX = -mapWidth / 2, maxX = mapWidth / 2;
+    float minZ = -mapHeight / 2, maxZ = mapHeight / 2;
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        minX = std::min(minX, walls[i]);
+        minZ = std::min(minZ, walls[i + 1]);
+        maxX = std::max(maxX, walls[i] + walls[i + 2]);
+        maxZ = std::max(maxZ, walls[i + 1] + walls[i + 3]);
+    }
+
+    cellSize = 1.0f / cellsPerUnit;
+    originX = minX;
+    originZ = minZ;
+    cols = (int)std::floor((maxX - minX) / cellSize) + 1;
+    rows = (int)std::floor((maxZ - minZ) / cellSize) + 1;
+    words = (cols + 63) / 64;
+    bits.assign((size_t)rows * words, 0);
+
+    // Растеризация боксов: граница бокса, попавшая ровно на край ячейки, помечает обе ячейки
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        int col0 = std::max(0, cellCol(walls[i]));
+        int col1 = std::min(cols - 1, cellCol(walls[i] + walls[i + 2]));
+        int row0 = std::max(0, cellRow(walls[i + 1]));
+        int row1 = std::min(rows - 1, cellRow(walls[i + 1] + walls[i + 3]));
+        for (int row = row0; row <= row1; row++) {
+            setSpan(row, col0, col1);
+        }
+    }
+}
+
+void OccupancyGrid::setSpan(int row, int col0, int col1) {
+    uint64_t* line = bits.data() + (size_t)row * words;
+    for (int word = col0 / 64; word <= col1 / 64; word++) {
+        line[word] |= wordMask(word, col0, col1 + 1);
+    }
+}
+
+int OccupancyGrid::findBlocked(int row, int col0, int col1) const {
+    int begin = std::max(col0, 0);
+    int end = std::min(col1, cols - 1) + 1;
+    if (row < 0 || row >= rows || begin >= end) {
+        return col1 + 1;
+    }
+    int col = findNext(getRow(row), begin, end, true);
+    return col < end ? col : col1 + 1;
+}
+
+int OccupancyGrid::findClear(int row, int col0, int col1) const {
+    if (col0 > col1) {
+        return col1 + 1;
+    }
+    // Ячейки вне сетки свободны
+    if (row < 0 || row >= rows || col0 < 0 || col0 >= cols) {
+        return col0;
+    }
+    int end = std::min(col1, cols - 1) + 1;
+    int col = findNext(getRow(row), col0, end, false);
+    return col < end ? col : std::min(col, col1 + 1);
+}
+
+bool OccupancyGrid::isAreaBlocked(float minX, float minZ, float maxX, float maxZ) const {
+    if (cols == 0) {
+        return false;
+    }
+    int col0 = cellCol(minX), col1 = cellCol(maxX);
+    int row0 = std::max(0, cellRow(minZ)), row1 = std::min(rows - 1, cellRow(maxZ));
+    for (int row = row0; row <= row1; row++) {
+        if (isSpanBlocked(row, col0, col1)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,55 @@
+#ifndef OCCUPANCY_GRID_H
+#define OCCUPANCY_GRID_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Битовая карта занятости: ячейка со стороной 1 / cellsPerUnit помечена, если её задевает
+// хоть один бокс стены (x, z, w, h). Строка ячеек упакована в слова по 64 бита.
+// Пометка консервативна: свободная ячейка гарантированно не касается ни одной стены
+class OccupancyGrid {
+public:
+    OccupancyGrid();
+    void build(const std::vector<float>& walls, float mapWidth, float mapHeight, float cellsPerUnit);
+    void clear();
+
+    int getCols() const { return cols; }
+    int getRows() const { return rows; }
+    float getCellSize() const { return cellSize; }
+    float getOriginX() const { return originX; }
+    float getOriginZ() const { return originZ; }
+
+    // Номер столбца/строки ячейки с точкой; может выйти за пределы сетки
+    int cellCol(float x) const;
+    int cellRow(float z) const;
+
+    bool isCellBlocked(int col, int row) const {
+        if (col < 0 || row < 0 || col >= cols || row >= rows) {
+            return false;
+        }
+        return (bits[(size_t)row * words + col / 64] >> (col % 64)) & 1;
+    }
+    // Есть ли стена в ячейке с точкой (x, z); вне сетки стен нет
+    bool isBlocked(float x, float z) const { return isCellBlocked(cellCol(x), cellRow(z)); }
+
+    // Первая занятая (или свободная) ячейка строки row в [col0, col1]; col1 + 1, если такой нет
+    int findBlocked(int row, int col0, int col1) const;
+    int findClear(int row, int col0, int col1) const;
+    bool isSpanBlocked(int row, int col0, int col1) const { return findBlocked(row, col0, col1) <= col1; }
+    // Задевает ли прямоугольник хоть одну занятую ячейку
+    bool isAreaBlocked(float minX, float minZ, float maxX, float maxZ) const;
+
+    const uint64_t* getRow(int row) const { return bits.data() + (size_t)row * words; }
+
+private:
+    void setSpan(int row, int col0, int col1);
+
+    float originX, originZ;
+    float cellSize;
+    int cols, rows;
+    int words;
+    std::vector<uint64_t> bits;
+};
+
+#endif
@@ -0,0 +1,514 @@
+#include "PNGRowReader.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+namespace {
+    const size_t fileBufferSize = 64 * 1024;
+    const size_t windowSize = 32 * 1024; // Максимальная дистанция ссылки deflate
+
+    // Основания и дополнительные биты длин (коды 257..285) и дистанций
+    const short lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                   35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    const short lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    const short distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                     257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                     8193, 12289, 16385, 24577 };
+    const short distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                      7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    // Порядок длин кодов для алфавита длин в динамическом блоке
+    const unsigned char codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    int paeth(int a, int b, int c) {
+        int p = a + b - c;
+        int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+        if (pa <= pb && pa <= pc) return a;
+        return pb <= pc ? b : c;
+    }
+}
+
+PNGRowReader::PNGRowReader() : file(nullptr), bufferPos(0), bufferEnd(0), idatRemaining(0), dataEnded(false),
+    bitBuffer(0), bitCount(0), windowPos(0), error(false), width(0), height(0), bitDepth(0), colorType(0),
+    channels(0), rowBytes(0), bytesPerPixel(0), rowFilled(0), row(0), rowCallback(nullptr) {
+    memset(palette, 0, sizeof(palette));
+}
+
+PNGRowReader::~PNGRowReader() {
+    close();
+}
+
+void PNGRowReader::close() {
+    if (file) {
+        fclose(file);
+        file = nullptr;
+    }
+    std::vector<unsigned char>().swap(fileBuffer);
+    std::vector<unsigned char>().swap(window);
+    std::vector<unsigned char>().swap(currentRow);
+    std::vector<unsigned char>().swap(previousRow);
+    std::vector<unsigned char>().swap(rgbRow);
+}
+
+int PNGRowReader::readFileByte() {
+    if (bufferPos == bufferEnd) {
+        bufferEnd = fread(fileBuffer.data(), 1, fileBuffer.size(), file);
+        bufferPos = 0;
+        if (bufferEnd == 0) {
+            return -1;
+        }
+    }
+    return fileBuffer[bufferPos++];
+}
+
+bool PNGRowReader::readFileBytes(unsigned char* dst, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        int byte = readFileByte();
+        if (byte < 0) {
+            return false;
+        }
+        dst[i] = (unsigned char)byte;
+    }
+    return true;
+}
+
+uint32_t PNGRowReader::readFileUInt32() {
+    unsigned char bytes[4];
+    if (!readFileBytes(bytes, 4)) {
+        error = true;
+        return 0;
+    }
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+bool PNGRowReader::open(const std::string& filename) {
+    close();
+    error = false;
+    file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    fileBuffer.resize(fileBufferSize);
+    bufferPos = bufferEnd = 0;
+
+    static const unsigned char signature[8] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+    unsigned char header[8];
+    if (!readFileBytes(header, 8) || memcmp(header, signature, 8) != 0) {
+        close();
+        return false;
+    }
+
+    bool headerRead = false;
+    int interlace = 0;
+    while (!error) {
+        uint32_t length = readFileUInt32();
+        char type[4];
+        if (error || !readFileBytes((unsigned char*)type, 4)) {
+            break;
+        }
+
+        if (memcmp(type, "IHDR", 4) == 0) {
+            unsigned char data[13];
+            if (length != 13 || !readFileBytes(data, 13)) {
+                break;
+            }
+            width = (int)(((uint32_t)data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3]);
+            height = (int)(((uint32_t)data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7]);
+            bitDepth = data[8];
+            colorType = data[9];
+            interlace = data[12];
+            headerRead = true;
+            length = 0;
+        } else if (memcmp(type, "PLTE", 4) == 0 && length <= sizeof(palette) && length % 3 == 0) {
+            if (!readFileBytes(palette, length)) {
+                break;
+            }
+            length = 0;
+        } else if (memcmp(type, "IDAT", 4) == 0) {
+            idatRemaining = length;
+            break;
+        } else if (memcmp(type, "IEND", 4) == 0) {
+            error = true;
+            break;
+        }
+
+        // Пропуск остатка чанка и CRC
+        for (uint32_t i = 0; i < length + 4 && !error; i++) {
+            if (readFileByte() < 0) {
+                error = true;
+            }
+        }
+    }
+
+    switch (colorType) {
+        case 0: channels = 1; break; // Оттенки серого
+        case 2: channels = 3; break; // RGB
+        case 3: channels = 1; break; // Палитра
+        case 4: channels = 2; break; // Серый с альфой
+        case 6: channels = 4; break; // RGBA
+        default: channels = 0; break;
+    }
+    bool validDepth = bitDepth == 8 || (bitDepth == 16 && colorType != 3)
+        || ((bitDepth == 1 || bitDepth == 2 || bitDepth == 4) && (colorType == 0 || colorType == 3));
+    if (error || !headerRead || channels == 0 || !validDepth || width <= 0 || height <= 0) {
+        close();
+        return false;
+    }
+    // Чересстрочное изображение не отдаёт строки по порядку
+    if (interlace != 0) {
+        close();
+        return false;
+    }
+
+    rowBytes = ((size_t)width * channels * bitDepth + 7) / 8;
+    bytesPerPixel = std::max(1, channels * bitDepth / 8);
+    return true;
+}
+
+int PNGRowReader::readDataByte() {
+    // Сжатый поток может быть разбит на несколько подряд идущих чанков IDAT
+    while (idatRemaining == 0) {
+        if (dataEnded) {
+            return -1;
+        }
+        readFileUInt32(); // CRC предыдущего чанка
+        uint32_t length = readFileUInt32();
+        char type[4];
+        if (error || !readFileBytes((unsigned char*)type, 4) || memcmp(type, "IDAT", 4) != 0) {
+            dataEnded = true;
+            return -1;
+        }
+        idatRemaining = length;
+    }
+    idatRemaining--;
+    return readFileByte();
+}
+
+int PNGRowReader::getBits(int count) {
+    while (bitCount < count) {
+        int byte = readDataByte();
+        if (byte < 0) {
+            error = true;
+            return 0;
+        }
+        bitBuffer |= (uint32_t)byte << bitCount;
+        bitCount += 8;
+    }
+    int value = (int)(bitBuffer & ((1u << count) - 1));
+    bitBuffer >>= count;
+    bitCount -= count;
+    return value;
+}
+
+bool PNGRowReader::buildHuffman(Huffman& huffman, const short* lengths, int count) {
+    memset(huffman.count, 0, sizeof(huffman.count));
+    for (int symbol = 0; symbol < count; symbol++) {
+        huffman.count[lengths[symbol]]++;
+    }
+    if (huffman.count[0] == count) {
+        return true; // Пустой алфавит допустим (блок без дистанций)
+    }
+
+    // Переподписанный набор длин не задаёт префиксный код
+    int left = 1;
+    for (int length = 1; length < 16; length++) {
+        left <<= 1;
+        left -= huffman.count[length];
+        if (left < 0) {
+            return false;
+        }
+    }
+
+    short offsets[16];
+    offsets[1] = 0;
+    for (int length = 1; length < 15; length++) {
+        offsets[length + 1] = offsets[length] + huffman.count[length];
+    }
+    for (int symbol = 0; symbol < count; symbol++) {
+        if (lengths[symbol] != 0) {
+            huffman.symbol[offsets[lengths[symbol]]++] = (short)symbol;
+        }
+    }
+    return true;
+}
+
+int PNGRowReader::decodeSymbol(const Huffman& huffman) {
+    // Канонический код: коды одной длины идут подряд, биты кода - от старшего к младшему
+    int code = 0, first = 0, index = 0;
+    for (int length = 1; length < 16; length++) {
+        code |= getBits(1);
+        int count = huffman.count[length];
+        if (code - count < first) {
+            return huffman.symbol[index + (code - first)];
+        }
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+    error = true;
+    return -1;
+}
+
+void PNGRowReader::output(unsigned char byte) {
+    // После ошибки (неверный фильтр строки) rowFilled не сброшен - дальше писать в строку нельзя
+    if (error) {
+        return;
+    }
+    window[windowPos++ & (windowSize - 1)] = byte;
+    if (row >= height) {
+        return;
+    }
+    currentRow[rowFilled++] = byte;
+    if (rowFilled == rowBytes + 1) {
+        finishRow();
+    }
+}
+
+bool PNGRowReader::inflateStored() {
+    bitBuffer = 0;
+    bitCount = 0;
+    int length = readDataByte();
+    length |= readDataByte() << 8;
+    int complement = readDataByte();
+    complement |= readDataByte() << 8;
+    if (length < 0 || complement < 0 || length != (~complement & 0xffff)) {
+        return false;
+    }
+    for (int i = 0; i < length && !error; i++) {
+        int byte = readDataByte();
+        if (byte < 0) {
+            return false;
+        }
+        output((unsigned char)byte);
+    }
+    return !error;
+}
+
+bool PNGRowReader::inflateCodes(const Huffman& lengthCodes, const Huffman& distanceCodes) {
+    while (!error) {
+        int symbol = decodeSymbol(lengthCodes);
+        if (symbol < 256) {
+            if (symbol < 0) {
+                return false;
+            }
+            output((unsigned char)symbol);
+            continue;
+        }
+        if (symbol == 256) {
+            return true;
+        }
+
+        symbol -= 257;
+        if (symbol >= 29) {
+            return false;
+        }
+        int length = lengthBase[symbol] + getBits(lengthExtra[symbol]);
+        symbol = decodeSymbol(distanceCodes);
+        if (symbol < 0 || symbol >= 30) {
+            return false;
+        }
+        size_t distance = distanceBase[symbol] + getBits(distanceExtra[symbol]);
+        if (distance > windowPos) {
+            return false;
+        }
+        // Источник может перекрываться с приёмником - копирование строго по байту
+        for (int i = 0; i < length && !error; i++) {
+            output(window[(windowPos - distance) & (windowSize - 1)]);
+        }
+    }
+    return false;
+}
+
+bool PNGRowReader::inflateFixed() {
+    // Фиксированные коды одни на все блоки и потоки - строятся один раз
+    struct FixedCodes {
+        Huffman lengthCodes, distanceCodes;
+        FixedCodes() {
+            short lengths[288];
+            int symbol = 0;
+            for (; symbol < 144; symbol++) lengths[symbol] = 8;
+            for (; symbol < 256; symbol++) lengths[symbol] = 9;
+            for (; symbol < 280; symbol++) lengths[symbol] = 7;
+            for (; symbol < 288; symbol++) lengths[symbol] = 8;
+            buildHuffman(lengthCodes, lengths, 288);
+            for (symbol = 0; symbol < 30; symbol++) lengths[symbol] = 5;
+            buildHuffman(distanceCodes, lengths, 30);
+        }
+    };
+    static const FixedCodes fixed;
+    return inflateCodes(fixed.lengthCodes, fixed.distanceCodes);
+}
+
+bool PNGRowReader::inflateDynamic() {
+    int lengthCount = getBits(5) + 257;
+    int distanceCount = getBits(5) + 1;
+    int codeLengthCount = getBits(4) + 4;
+    if (error || lengthCount > 286 || distanceCount > 30) {
+        return false;
+    }
+
+    short lengths[286 + 30];
+    memset(lengths, 0, sizeof(lengths));
+    for (int i = 0; i < codeLengthCount; i++) {
+        lengths[codeLengthOrder[i]] = (short)getBits(3);
+    }
+    Huffman lengthCodes, distanceCodes;
+    if (!buildHuffman(lengthCodes, lengths, 19)) {
+        return false;
+    }
+
+    // Длины кодов литералов и дистанций идут одним потоком с кодами повтора
+    int index = 0;
+    while (index < lengthCount + distanceCount && !error) {
+        int symbol = decodeSymbol(lengthCodes);
+        if (symbol < 0) {
+            return false;
+        }
+        if (symbol < 16) {
+            lengths[index++] = (short)symbol;
+            continue;
+        }
+        short value = 0;
+        int repeat;
+        if (symbol == 16) {
+            if (index == 0) {
+                return false;
+            }
+            value = lengths[index - 1];
+            repeat = 3 + getBits(2);
+        } else if (symbol == 17) {
+            repeat = 3 + getBits(3);
+        } else {
+            repeat = 11 + getBits(7);
+        }
+        if (index + repeat > lengthCount + distanceCount) {
+            return false;
+        }
+        while (repeat--) {
+            lengths[index++] = value;
+        }
+    }
+    if (error || lengths[256] == 0) {
+        return false;
+    }
+
+    if (!buildHuffman(lengthCodes, lengths, lengthCount)
+        || !buildHuffman(distanceCodes, lengths + lengthCount, distanceCount)) {
+        return false;
+    }
+    return inflateCodes(lengthCodes, distanceCodes);
+}
+
+void PNGRowReader::finishRow() {
+    // Снятие фильтра строки; предыдущая строка уже восстановлена
+    unsigned char* data = currentRow.data() + 1;
+    const unsigned char* prior = previousRow.data() + 1;
+    int filter = currentRow[0];
+    switch (filter) {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = bytesPerPixel; i < rowBytes; i++) {
+                data[i] = (unsigned char)(data[i] + data[i - bytesPerPixel]);
+            }
+            break;
+        case 2:
+            for (size_t i = 0; i < rowBytes; i++) {
+                data[i] = (unsigned char)(data[i] + prior[i]);
+            }
+            break;
+        case 3:
+            for (size_t i = 0; i < rowBytes; i++) {
+                int left = i >= (size_t)bytesPerPixel ? data[i - bytesPerPixel] : 0;
+                data[i] = (unsigned char)(data[i] + ((left + prior[i]) >> 1));
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < rowBytes; i++) {
+                int left = i >= (size_t)bytesPerPixel ? data[i - bytesPerPixel] : 0;
+                int upperLeft = i >= (size_t)bytesPerPixel ? prior[i - bytesPerPixel] : 0;
+                data[i] = (unsigned char)(data[i] + paeth(left, prior[i], upperLeft));
+            }
+            break;
+        default:
+            error = true;
+            return;
+    }
+
+    // Перевод в RGB 8 бит: от 16-битных отсчётов берётся старший байт, альфа отбрасывается
+    unsigned char* rgb = rgbRow.data();
+    if (bitDepth < 8) {
+        int mask = (1 << bitDepth) - 1;
+        int scale = colorType == 0 ? 255 / mask : 1;
+        for (int x = 0; x < width; x++) {
+            size_t bit = (size_t)x * bitDepth;
+            int value = (data[bit >> 3] >> (8 - bitDepth - (bit & 7))) & mask;
+            if (colorType == 3) {
+                memcpy(rgb + x * 3, palette + value * 3, 3);
+            } else {
+                rgb[x * 3] = rgb[x * 3 + 1] = rgb[x * 3 + 2] = (unsigned char)(value * scale);
+            }
+        }
+    } else {
+        int sampleBytes = bitDepth / 8;
+        int pixelBytes = channels * sampleBytes;
+        for (int x = 0; x < width; x++) {
+            const unsigned char* pixel = data + (size_t)x * pixelBytes;
+            unsigned char* out = rgb + (size_t)x * 3;
+            if (colorType == 3) {
+                memcpy(out, palette + pixel[0] * 3, 3);
+            } else if (channels < 3) {
+                out[0] = out[1] = out[2] = pixel[0];
+            } else {
+                out[0] = pixel[0];
+                out[1] = pixel[sampleBytes];
+                out[2] = pixel[2 * sampleBytes];
+            }
+        }
+    }
+
+    (*rowCallback)(rgb, row);
+    row++;
+    currentRow.swap(previousRow);
+    rowFilled = 0;
+}
+
+bool PNGRowReader::readRows(const std::function<void(const unsigned char* rgb, int y)>& onRow) {
+    if (!file) {
+        return false;
+    }
+    rowCallback = &onRow;
+    window.assign(windowSize, 0);
+    windowPos = 0;
+    currentRow.assign(rowBytes + 1, 0);
+    previousRow.assign(rowBytes + 1, 0);
+    rgbRow.assign((size_t)width * 3, 0);
+    rowFilled = 0;
+    row = 0;
+    bitBuffer = 0;
+    bitCount = 0;
+    dataEnded = false;
+
+    // Заголовок zlib: метод 8 (deflate), без предустановленного словаря
+    int cmf = readDataByte();
+    int flags = readDataByte();
+    bool ok = cmf >= 0 && flags >= 0 && (cmf & 0x0f) == 8 && (cmf * 256 + flags) % 31 == 0 && !(flags & 0x20);
+
+    bool last = false;
+    while (ok && !last && !error) {
+        last = getBits(1) != 0;
+        int type = getBits(2);
+        switch (type) {
+            case 0: ok = inflateStored(); break;
+            case 1: ok = inflateFixed(); break;
+            case 2: ok = inflateDynamic(); break;
+            default: ok = false; break;
+        }
+    }
+
+    rowCallback = nullptr;
+    ok = ok && !error && row == height;
+    close();
+    return ok;
+}
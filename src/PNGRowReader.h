@@ -0,0 +1,78 @@
+#ifndef PNG_ROW_READER_H
+#define PNG_ROW_READER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <functional>
+
+// Построчное чтение PNG без буфера на всё изображение: сжатые данные читаются из файла
+// порциями, распаковка идёт через окно 32 КБ, в памяти - только текущая и предыдущая строки.
+// Строки отдаются как RGB по 3 байта на пиксель, так же как stbi_load(..., 3)
+class PNGRowReader {
+public:
+    PNGRowReader();
+    ~PNGRowReader();
+    PNGRowReader(const PNGRowReader&) = delete;
+    PNGRowReader& operator=(const PNGRowReader&) = delete;
+
+    // Читает заголовок. false - не PNG или формат нельзя читать построчно (чересстрочный Adam7)
+    bool open(const std::string& filename);
+    void close();
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+
+    // Распаковывает строки сверху вниз и вызывает onRow(rgb, y) для каждой
+    bool readRows(const std::function<void(const unsigned char* rgb, int y)>& onRow);
+
+private:
+    struct Huffman {
+        short count[16];
+        short symbol[288];
+    };
+
+    // Файл и поток данных из последовательных чанков IDAT
+    int readFileByte();
+    bool readFileBytes(unsigned char* dst, size_t size);
+    uint32_t readFileUInt32();
+    int readDataByte();
+
+    // Распаковка deflate (RFC 1951)
+    int getBits(int count);
+    static bool buildHuffman(Huffman& huffman, const short* lengths, int count);
+    int decodeSymbol(const Huffman& huffman);
+    bool inflateStored();
+    bool inflateCodes(const Huffman& lengthCodes, const Huffman& distanceCodes);
+    bool inflateFixed();
+    bool inflateDynamic();
+    void output(unsigned char byte);
+
+    // Сборка строк, снятие фильтров PNG и перевод в RGB
+    void finishRow();
+
+    FILE* file;
+    std::vector<unsigned char> fileBuffer;
+    size_t bufferPos, bufferEnd;
+    uint32_t idatRemaining;
+    bool dataEnded;
+
+    uint32_t bitBuffer;
+    int bitCount;
+    std::vector<unsigned char> window;
+    size_t windowPos;
+    bool error;
+
+    int width, height;
+    int bitDepth, colorType, channels;
+    unsigned char palette[256 * 3];
+    size_t rowBytes;
+    int bytesPerPixel;
+    std::vector<unsigned char> currentRow, previousRow, rgbRow;
+    size_t rowFilled;
+    int row;
+    const std::function<void(const unsigned char*, int)>* rowCallback;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+// Число полос для разбиения count строк по ядрам процессора
+inline int parallelBandCount(int count) {
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    return std::max(1, std::min(threads, count));
+}
+
+// Делит [0, count) на bands полос и вызывает body(полоса, начало, конец) в отдельных потоках
+template <typename Body>
+void parallelBands(int count, int bands, Body body) {
+    if (bands <= 1) {
+        body(0, 0, count);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (int band = 0; band < bands; band++) {
+        workers.emplace_back(body, band, (int)((long long)count * band / bands), (int)((long long)count * (band + 1) / bands));
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+#endif
@@ -0,0 +1,196 @@
+#include "PixelClassifier.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CLASSIFIER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CLASSIFIER_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+void classifyScalar(const unsigned char* rgb, int begin, int width, uint64_t* bits) {
+    for (int x = begin; x < width; x++) {
+        const unsigned char* pixel = rgb + x * 3;
+        if ((pixel[0] | pixel[1] | pixel[2]) == 0) {
+            bits[x >> 6] |= 1ull << (x & 63);
+        }
+    }
+}
+
+// Маска нулевых байтов 48 байт (16 пикселей) -> 16 бит "все три байта пикселя нулевые"
+inline uint64_t pixelZeroMask(uint64_t byteZeroMask) {
+    return byteZeroMask & (byteZeroMask >> 1) & (byteZeroMask >> 2);
+}
+
+#ifdef CLASSIFIER_SSE2
+
+// Биты пикселей лежат на позициях 0, 3, ..., 45. В байте i первый из них со сдвигом
+// (3 - 8i % 3) % 3, поэтому хватает трёх таблиц по фазе сдвига
+struct GatherTables {
+    unsigned char phase[3][256];
+    GatherTables() {
+        for (int p = 0; p < 3; p++) {
+            for (int v = 0; v < 256; v++) {
+                unsigned char out = 0;
+                for (int bit = p, k = 0; bit < 8; bit += 3, k++) {
+                    if (v & (1 << bit)) {
+                        out |= 1 << k;
+                    }
+                }
+                phase[p][v] = out;
+            }
+        }
+    }
+};
+const GatherTables gatherTables;
+
+inline uint32_t gatherEveryThirdBit(uint64_t t) {
+    return gatherTables.phase[0][t & 0xFF]
+        | (uint32_t)gatherTables.phase[1][(t >> 8) & 0xFF] << 3
+        | (uint32_t)gatherTables.phase[2][(t >> 16) & 0xFF] << 6
+        | (uint32_t)gatherTables.phase[0][(t >> 24) & 0xFF] << 8
+        | (uint32_t)gatherTables.phase[1][(t >> 32) & 0xFF] << 11
+        | (uint32_t)gatherTables.phase[2][(t >> 40) & 0xFF] << 14;
+}
+
+void classifySSE2(const unsigned char* rgb, int width, uint64_t* bits) {
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const unsigned char* p = rgb + x * 3;
+        uint64_t m0 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), zero));
+        uint64_t m1 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 16)), zero));
+        uint64_t m2 = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + 32)), zero));
+        uint64_t pixels = gatherEveryThirdBit(pixelZeroMask(m0 | m1 << 16 | m2 << 32));
+        bits[x >> 6] |= pixels << (x & 63);
+    }
+    classifyScalar(rgb, x, width, bits);
+}
+
+#endif
+
+#ifdef CLASSIFIER_AVX2
+
+__attribute__((target("avx2,bmi2")))
+void classifyAVX2(const unsigned char* rgb, int width, uint64_t* bits) {
+    const __m256i zero = _mm256_setzero_si256();
+    const uint64_t pixelBits = 0x249249249249ull;  // Биты 0, 3, ..., 45
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const unsigned char* p = rgb + x * 3;
+        uint64_t m0 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), zero));
+        uint64_t m1 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 32)), zero));
+        uint64_t m2 = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + 64)), zero));
+        // 96 байт = две группы по 48 байт (16 пикселей)
+        uint64_t low = m0 | (m1 & 0xFFFF) << 32;
+        uint64_t high = m1 >> 16 | m2 << 16;
+        uint64_t pixels = _pext_u64(pixelZeroMask(low), pixelBits) | _pext_u64(pixelZeroMask(high), pixelBits) << 16;
+        bits[x >> 6] |= pixels << (x & 63);
+    }
+    classifyScalar(rgb, x, width, bits);
+}
+
+#endif
+
+}
+
+bool PixelClassifier::isSupported(ClassifierPath path) {
+    switch (path) {
+    case ClassifierPath::SCALAR:
+        return true;
+    case ClassifierPath::SSE2:
+#ifdef CLASSIFIER_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case ClassifierPath::AVX2:
+#ifdef CLASSIFIER_AVX2
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2");
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+ClassifierPath PixelClassifier::bestPath() {
+    static const ClassifierPath best = isSupported(ClassifierPath::AVX2) ? ClassifierPath::AVX2
+        : (isSupported(ClassifierPath::SSE2) ? ClassifierPath::SSE2 : ClassifierPath::SCALAR);
+    return best;
+}
+
+const char* PixelClassifier::pathName(ClassifierPath path) {
+    switch (path) {
+    case ClassifierPath::SCALAR: return "scalar";
+    case ClassifierPath::SSE2: return "SSE2";
+    case ClassifierPath::AVX2: return "AVX2";
+    }
+    return "?";
+}
+
+void PixelClassifier::classifyRow(const unsigned char* rgb, int width, uint64_t* bits) {
+    classifyRow(rgb, width, bits, bestPath());
+}
+
+void PixelClassifier::classifyRow(const unsigned char* rgb, int width, uint64_t* bits, ClassifierPath path) {
+    memset(bits, 0, wordsForWidth(width) * sizeof(uint64_t));
+    switch (path) {
+#ifdef CLASSIFIER_AVX2
+    case ClassifierPath::AVX2:
+        classifyAVX2(rgb, width, bits);
+        return;
+#endif
+#ifdef CLASSIFIER_SSE2
+    case ClassifierPath::SSE2:
+        classifySSE2(rgb, width, bits);
+        return;
+#endif
+    default:
+        classifyScalar(rgb, 0, width, bits);
+        return;
+    }
+}
+
+void PixelClassifier::runBenchmark() {
+    // Строка как в лабиринте: отрезки стен и проходов случайной длины
+    const int width = 16384;
+    const int iterations = 4000;
+    std::vector<unsigned char> row(width * 3);
+    std::mt19937 random(12345);
+    for (int x = 0; x < width;) {
+        int length = 1 + random() % 24;
+        unsigned char value = (random() & 1) ? 0 : 255;
+        for (; length > 0 && x < width; length--, x++) {
+            row[x * 3] = row[x * 3 + 1] = row[x * 3 + 2] = value;
+        }
+    }
+
+    std::vector<uint64_t> reference(wordsForWidth(width));
+    std::vector<uint64_t> bits(wordsForWidth(width));
+    classifyRow(row.data(), width, reference.data(), ClassifierPath::SCALAR);
+
+    const ClassifierPath paths[] = { ClassifierPath::SCALAR, ClassifierPath::SSE2, ClassifierPath::AVX2 };
+    for (ClassifierPath path : paths) {
+        if (!isSupported(path)) {
+            printf("%-6s : недоступен\n", pathName(path));
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            classifyRow(row.data(), width, bits.data(), path);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bool matches = bits == reference;
+        printf("%-6s : %8.1f Мпикс/с%s\n", pathName(path), (double)width * iterations / seconds / 1e6, matches ? "" : " (РЕЗУЛЬТАТ НЕ СОВПАДАЕТ)");
+    }
+}
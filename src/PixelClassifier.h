@@ -0,0 +1,25 @@
+#ifndef PIXEL_CLASSIFIER_H
+#define PIXEL_CLASSIFIER_H
+
+#include <cstdint>
+
+enum class ClassifierPath { SCALAR, SSE2, AVX2 };
+
+// Перевод строки RGB в битовую карту занятости: бит x (слово x / 64, бит x % 64)
+// установлен, если пиксель x чёрный, то есть стена. Векторные пути выбираются по процессору
+class PixelClassifier {
+public:
+    static int wordsForWidth(int width) { return (width + 63) / 64; }
+
+    static void classifyRow(const unsigned char* rgb, int width, uint64_t* bits);
+    static void classifyRow(const unsigned char* rgb, int width, uint64_t* bits, ClassifierPath path);
+
+    static ClassifierPath bestPath();
+    static bool isSupported(ClassifierPath path);
+    static const char* pathName(ClassifierPath path);
+
+    // Печатает скорость каждого доступного пути в пикселях в секунду
+    static void runBenchmark();
+};
+
+#endif
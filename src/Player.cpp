@@ -7,10 +7,14 @@ float Player::x = 0.0f;
 float Player::y = 0.0f;
 float Player::z = 0.0f;
 float Player::angle = 0.0f;
-
-void Player::update(Game& game) {
-    float speed = 0.005f;
-    float rotSpeed = 0.005f;
+float Player::prevX = 0.0f;
+float Player::prevZ = 0.0f;
+float Player::prevAngle = 0.0f;
+float Player::interpolation = 1.0f;
+
+void Player::update(Game& game, float dt) {
+    float speed = 3.0f * dt;     // единиц в секунду
+    float rotSpeed = 2.0f * dt;  // радиан в секунду
     float newX = x, newZ = z;
 
     if (InputHandler::isSpecialKeyPressed(GLUT_KEY_UP) || InputHandler::isKeyPressed('w') || InputHandler::isKeyPressed('W')) {
@@ -37,31 +41,15 @@ void Player::update(Game& game) {
         angle -= rotSpeed;
     }
 
-    bool collision = false;
-    const std::vector<float>& walls = Maze::getInstance().getWalls();
-    for (size_t i = 0; i < walls.size(); i += 4) {
-        if (checkCollision(newX, newZ, walls[i], walls[i + 1], walls[i + 2], walls[i + 3])) {
-            collision = true;
-            break;
-        }
-    }
-
-    if (!collision) {
-        x = newX;
-        z = newZ;
-    }
+    Maze::getInstance().moveAndSlide(x, z, newX - x, newZ - z, radius);
 
     if (fabs(x - Maze::getInstance().getExitX()) < 0.5f && fabs(z - Maze::getInstance().getExitZ()) < 0.5f) {
         game.setState(GameState::WIN);
     }
-
-    glutPostRedisplay();
 }
 
-bool Player::checkCollision(float newX, float newZ, float x, float z, float width, float height) {
-    float minX = x - 0.2f;
-    float maxX = x + width + 0.2f;
-    float minZ = z - 0.2f;
-    float maxZ = z + height + 0.2f;
-    return (newX >= minX && newX <= maxX && newZ >= minZ && newZ <= maxZ);
+void Player::storePreviousState() {
+    prevX = x;
+    prevZ = z;
+    prevAngle = angle;
 }
\ No newline at end of file
@@ -5,21 +5,31 @@
 
 class Player {
 public:
-    static void update(Game& game);
+    static void update(Game& game, float dt);
+    static void storePreviousState();
+    static void setInterpolation(float alpha) { interpolation = alpha; }
 
     static float getX() { return x; }
     static float getY() { return y; }
     static float getZ() { return z; }
     static float getAngle() { return angle; }
 
-    static void setX(float newX) { x = newX; }
-    static void setZ(float newZ) { z = newZ; }
-    static void setAngle(float newAngle) { angle = newAngle; }
-    static bool checkCollision(float newX, float newZ, float x, float z, float width, float height);
+    // Положение для отрисовки: между двумя последними тиками симуляции
+    static float getRenderX() { return prevX + (x - prevX) * interpolation; }
+    static float getRenderZ() { return prevZ + (z - prevZ) * interpolation; }
+    static float getRenderAngle() { return prevAngle + (angle - prevAngle) * interpolation; }
+
+    static void setX(float newX) { x = prevX = newX; }
+    static void setZ(float newZ) { z = prevZ = newZ; }
+    static void setAngle(float newAngle) { angle = prevAngle = newAngle; }
+
+    static constexpr float radius = 0.2f;  // Насколько игрок не может приблизиться к стене
 
 private:
     static float x, y, z;
     static float angle;
+    static float prevX, prevZ, prevAngle;
+    static float interpolation;
 };
 
 #endif
\ No newline at end of file
@@ -1,14 +1,142 @@
 #include "Renderer.h"
 #include "Maze.h"
 #include "Player.h"
+#include "GLExtensions.h"
+#include "TextureManager.h"
+#include "Parallel.h"
+#include "CoreRenderer.h"
 #include <cmath>
-#include "C:\LabyrinthProject\include\stb_image.h"
+#include <cstddef>
+#include <algorithm>
+#include <map>
+#include <tuple>
 
 GLuint Renderer::wallTexture = 0;
 GLuint Renderer::floorTexture = 0;
 GLfloat Renderer::lightPos[] = { 0.0f, 10.0f, 0.0f, 1.0f };
+GLfloat Renderer::lightDiffuse[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+GLfloat Renderer::ambientLight[] = { 0.2f, 0.2f, 0.2f, 1.0f };
+GLfloat Renderer::fogColor[] = { 0.5f, 0.5f, 0.5f, 1.0f };
+const float Renderer::fogStart = 5.0f;
+const float Renderer::fogEnd = Maze::viewDistance;
+std::vector<Renderer::WallVertex> Renderer::wallVertices;
+std::vector<GLuint> Renderer::wallIndices;
+GLuint Renderer::wallVertexBuffer = 0;
+GLuint Renderer::wallIndexBuffer = 0;
+GLsizei Renderer::wallIndexCount = 0;
+WallRendering Renderer::wallRendering = WallRendering::MESH;
+std::vector<int> Renderer::instanceWalls;
+GLuint Renderer::wallInstanceBuffer = 0;
+GLuint Renderer::unitBoxBuffer = 0;
+GLsizei Renderer::unitBoxVertexCount = 0;
+ShaderProgram Renderer::wallProgram;
+std::vector<Renderer::WallCluster> Renderer::wallClusters;
+std::vector<int> Renderer::clusterOfCell;
+float Renderer::clusterOverhang = 0.0f;
+int Renderer::drawnWallCount = 0;
+int Renderer::culledWallCount = 0;
+bool Renderer::occlusionCulling = false;
+int Renderer::occludedClusterCount = 0;
+int Renderer::occlusionFrame = 0;
+
+// Ближе этого к боксу кластера ближняя плоскость может срезать его переднюю грань,
+// и проверка боксом перестаёт быть надёжной
+static const float occlusionNearMargin = 0.5f;
+
+// PVS приближённый (см. VisibilityGrid): камера между точками запуска лучей может увидеть за близким
+// углом стену, которой в нём нет. Кластеры ближе этого рисуются без PVS - вблизи такой пропуск заметнее всего
+static const float pvsNearDistance = 2.0f * VisibilityGrid::cellSize;
+
+// Номер атрибута (x, z, w, h) экземпляра; 6 и 7 не совпадают со встроенными атрибутами ни у одного драйвера
+static const GLuint wallInstanceAttribute = 6;
+
+// Освещение и туман те же, что у фиксированного конвейера с GL_COLOR_MATERIAL: фоновое освещение
+// сцены, источник 0 без ослабления, линейный туман по глубине
+static const char* wallVertexShader = R"(
+#version 120
+attribute vec4 wall;
+varying vec4 color;
+varying vec2 texCoord;
+varying float fogDepth;
+
+void main() {
+    vec4 position = vec4(wall.x + gl_Vertex.x * wall.z, gl_Vertex.y, wall.y + gl_Vertex.z * wall.w, 1.0);
+    vec4 eye = gl_ModelViewMatrix * position;
+    gl_Position = gl_ProjectionMatrix * eye;
+
+    // Как у сетки: вдоль стороны - половина мировой координаты, по высоте 0..1
+    texCoord = vec2(mix(position.x, position.z, gl_MultiTexCoord0.y) * 0.5, gl_MultiTexCoord0.x);
+
+    vec3 normal = normalize(gl_NormalMatrix * gl_Normal);
+    vec4 light = gl_LightSource[0].position;
+    vec3 toLight = normalize(light.xyz - eye.xyz * light.w);
+    vec3 lit = (gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb) * gl_Color.rgb
+        + max(dot(normal, toLight), 0.0) * gl_LightSource[0].diffuse.rgb * gl_Color.rgb;
+    color = vec4(lit, gl_Color.a);
+    fogDepth = abs(eye.z);
+}
+)";
+
+static const char* wallFragmentShader = R"(
+#version 120
+uniform sampler2D wallTexture;
+uniform bool textured;
+varying vec4 color;
+varying vec2 texCoord;
+varying float fogDepth;
+
+void main() {
+    vec4 result = textured ? color * texture2D(wallTexture, texCoord) : color;
+    float fog = clamp((gl_Fog.end - fogDepth) * gl_Fog.scale, 0.0, 1.0);
+    gl_FragColor = vec4(mix(gl_Fog.color.rgb, result.rgb, fog), result.a);
+}
+)";
+std::vector<GLfloat> Renderer::shadowVertices;
+GLuint Renderer::shadowVertexBuffer = 0;
+GLsizei Renderer::shadowVertexCount = 0;
+GLsizei Renderer::shadowCapVertexCount = 0;
+GLfloat Renderer::shadowLightPos[3] = { 0.0f, 0.0f, 0.0f };
+RenderBackend Renderer::backend = RenderBackend::FIXED_FUNCTION;
+ShadowMode Renderer::shadowMode = ShadowMode::STENCIL;
+GLuint Renderer::lightmapTexture = 0;
 
 void Renderer::initialize() {
+    GLExtensions::initialize();
+    if (backend == RenderBackend::CORE && !GLExtensions::hasCorePipeline()) {
+        printf("OpenGL 3.3 недоступен, используется фиксированный конвейер\n");
+        backend = RenderBackend::FIXED_FUNCTION;
+    }
+    if (backend == RenderBackend::CORE && !CoreRenderer::initialize()) {
+        printf("Шейдеры конвейера GL 3.3 не собраны, используется фиксированный конвейер\n");
+        backend = RenderBackend::FIXED_FUNCTION;
+    }
+    if (backend == RenderBackend::CORE) {
+        // Стены в нём - только экземпляры единичного бокса, запросов видимости нет
+        if (wallRendering == WallRendering::MESH) {
+            printf("В конвейере GL 3.3 стены рисуются экземплярами\n");
+        }
+        wallRendering = WallRendering::INSTANCED;
+        if (occlusionCulling) {
+            printf("В конвейере GL 3.3 отсечение перекрытых стен не поддерживается\n");
+            occlusionCulling = false;
+        }
+    }
+    if (shadowMode == ShadowMode::LIGHTMAP && !GLExtensions::hasMultitexture()) {
+        printf("Мультитекстурирование недоступно, используются стенсильные тени\n");
+        shadowMode = ShadowMode::STENCIL;
+    }
+    if (wallRendering == WallRendering::INSTANCED) {
+        buildWallInstancing();
+    }
+    if (occlusionCulling && !GLExtensions::hasOcclusionQueries()) {
+        printf("Запросы видимости недоступны, отсечение перекрытых стен отключено\n");
+        occlusionCulling = false;
+    }
+    // Дальше - состояние фиксированного конвейера; CoreRenderer выставляет своё в каждом кадре
+    if (backend == RenderBackend::CORE) {
+        return;
+    }
+
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_LIGHTING);
     glEnable(GL_LIGHT0);
@@ -17,17 +145,13 @@ void Renderer::initialize() {
     glEnable(GL_TEXTURE_2D);
 
     glEnable(GL_FOG);
-    GLfloat fogColor[4] = {0.5f, 0.5f, 0.5f, 1.0f};
     glFogfv(GL_FOG_COLOR, fogColor);
     glFogf(GL_FOG_MODE, GL_LINEAR);
-    glFogf(GL_FOG_START, 5.0f);
-    glFogf(GL_FOG_END, 15.0f);
-
-    GLfloat diffuse[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuse);
+    glFogf(GL_FOG_START, fogStart);
+    glFogf(GL_FOG_END, fogEnd);
 
-    GLfloat ambient[] = { 0.2f, 0.2f, 0.2f, 1.0f };
-    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambient);
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, lightDiffuse);
+    glLightModelfv(GL_LIGHT_MODEL_AMBIENT, ambientLight);
 
     glLightf(GL_LIGHT0, GL_CONSTANT_ATTENUATION, 1.0f);
     glLightf(GL_LIGHT0, GL_LINEAR_ATTENUATION, 0.0f);
@@ -35,38 +159,21 @@ void Renderer::initialize() {
     glLightf(GL_LIGHT0, GL_SPOT_CUTOFF, 180.0f);
 }
 
-void Renderer::loadTexture(const std::string& filename, GLuint& textureID) {
-    int width, height, channels;
-    unsigned char* image = stbi_load(filename.c_str(), &width, &height, &channels, 0);
-    if (!image) {
-        printf("Не удалось загрузить текстуру: %s\n", filename.c_str());
-        textureID = 0;
-        return;
-    }
+void Renderer::loadTexture(const std::string& filename, GLuint& textureID, const TextureManager::Image* decoded) {
+    // Сначала берём новую ссылку, потом отпускаем старую: тот же файл не перезагружается
+    GLuint newTexture = TextureManager::acquire(filename, decoded);
+    TextureManager::release(textureID);
+    textureID = newTexture;
+}
 
-    GLint maxTextureSize;
-    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
-    if (width > maxTextureSize || height > maxTextureSize) {
-        printf("Ошибка: размер текстуры %dx%d превышает максимальный %d\n", width, height, maxTextureSize);
-        stbi_image_free(image);
-        textureID = 0;
+void Renderer::drawScene(bool showMiniMap) {
+    if (backend == RenderBackend::CORE) {
+        CoreRenderer::drawScene(showMiniMap);
         return;
     }
 
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, channels == 3 ? GL_RGB : GL_RGBA, GL_UNSIGNED_BYTE, image);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    stbi_image_free(image);
-}
-
-void Renderer::drawScene(bool showMiniMap) {
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    // Фон цвета тумана: стены дальше fogEnd не рисуются, и без этого на их месте была бы дыра
+    glClearColor(fogColor[0], fogColor[1], fogColor[2], fogColor[3]);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
     glLoadIdentity();
 
@@ -76,9 +183,9 @@ void Renderer::drawScene(bool showMiniMap) {
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
 
-    float lookX = Player::getX() + sin(Player::getAngle());
-    float lookZ = Player::getZ() + cos(Player::getAngle());
-    gluLookAt(Player::getX(), Player::getY(), Player::getZ(), lookX, Player::getY(), lookZ, 0.0, 1.0, 0.0);
+    float lookX = Player::getRenderX() + sin(Player::getRenderAngle());
+    float lookZ = Player::getRenderZ() + cos(Player::getRenderAngle());
+    gluLookAt(Player::getRenderX(), Player::getY(), Player::getRenderZ(), lookX, Player::getY(), lookZ, 0.0, 1.0, 0.0);
 
     glLightfv(GL_LIGHT0, GL_POSITION, lightPos);
 
@@ -94,6 +201,13 @@ void Renderer::drawScene(bool showMiniMap) {
     } else {
         glColor3f(0.5f, 0.5f, 0.5f);
     }
+    bool floorLightmap = shadowMode == ShadowMode::LIGHTMAP && lightmapTexture;
+    if (floorLightmap && (lightPos[0] != shadowLightPos[0] || lightPos[1] != shadowLightPos[1] || lightPos[2] != shadowLightPos[2])) {
+        bakeFloorLightmap();
+    }
+    if (floorLightmap) {
+        enableFloorLightmap();
+    }
     glBegin(GL_QUADS);
     glNormal3f(0.0f, 1.0f, 0.0f);
     glTexCoord2f(0.0f, 0.0f); glVertex3f(-Maze::getInstance().getWidth() / 2, -1.0f, -Maze::getInstance().getHeight() / 2);
@@ -101,15 +215,27 @@ void Renderer::drawScene(bool showMiniMap) {
     glTexCoord2f(Maze::getInstance().getWidth() / 2.0f, Maze::getInstance().getHeight() / 2.0f); glVertex3f(Maze::getInstance().getWidth() / 2, -1.0f, Maze::getInstance().getHeight() / 2);
     glTexCoord2f(0.0f, Maze::getInstance().getHeight() / 2.0f); glVertex3f(-Maze::getInstance().getWidth() / 2, -1.0f, Maze::getInstance().getHeight() / 2);
     glEnd();
+    if (floorLightmap) {
+        disableFloorLightmap();
+    }
     glBindTexture(GL_TEXTURE_2D, 0);
 
-    const std::vector<float>& walls = Maze::getInstance().getWalls();
-    for (size_t i = 0; i < walls.size(); i += 4) {
-        drawWall(walls[i], walls[i + 1], walls[i + 2], walls[i + 3]);
-    }
+    drawWalls();
 
     drawExit(Maze::getInstance().getExitX(), -0.5f, Maze::getInstance().getExitZ());
 
+    if (shadowMode == ShadowMode::STENCIL) {
+        drawStencilShadows();
+    }
+
+    if (showMiniMap) {
+        drawMiniMap();
+    }
+
+    glutSwapBuffers();
+}
+
+void Renderer::drawStencilShadows() {
     glDisable(GL_LIGHTING);
     glDisable(GL_TEXTURE_2D);
     glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
@@ -117,18 +243,11 @@ void Renderer::drawScene(bool showMiniMap) {
     glEnable(GL_STENCIL_TEST);
     glEnable(GL_CULL_FACE);
 
-    glCullFace(GL_BACK);
-    glStencilFunc(GL_ALWAYS, 0, ~0);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
-    for (size_t i = 0; i < walls.size(); i += 4) {
-        drawShadowVolume(walls[i], walls[i + 1], walls[i + 2], walls[i + 3]);
-    }
-
-    glCullFace(GL_FRONT);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_DECR);
-    for (size_t i = 0; i < walls.size(); i += 4) {
-        drawShadowVolume(walls[i], walls[i + 1], walls[i + 2], walls[i + 3]);
+    // Свет статичен: объёмы теней пересобираются, только если он сдвинулся
+    if (lightPos[0] != shadowLightPos[0] || lightPos[1] != shadowLightPos[1] || lightPos[2] != shadowLightPos[2]) {
+        buildShadowVolumes();
     }
+    drawShadowVolumes();
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -149,12 +268,6 @@ void Renderer::drawScene(bool showMiniMap) {
     glDisable(GL_STENCIL_TEST);
     glEnable(GL_LIGHTING);
     glEnable(GL_TEXTURE_2D);
-
-    if (showMiniMap) {
-        drawMiniMap();
-    }
-
-    glutSwapBuffers();
 }
 
 void Renderer::drawMenu() {
@@ -208,6 +321,21 @@ void Renderer::drawMenu() {
     glColor3f(1.0f, 1.0f, 1.0f);
     drawText(0.4375f * windowWidth, 0.366f * windowHeight, "Hard");
 
+    const std::vector<WADFile::MapEntry>& maps = Maze::getInstance().getWADMaps();
+    for (size_t i = 0; i < maps.size(); i++) {
+        float x, y, w, h;
+        getMapButtonRect((int)i, x, y, w, h);
+        glColor3f(0.3f, 0.3f, 0.3f);
+        glBegin(GL_QUADS);
+        glVertex2f(x, y);
+        glVertex2f(x + w, y);
+        glVertex2f(x + w, y + h);
+        glVertex2f(x, y + h);
+        glEnd();
+        glColor3f(1.0f, 1.0f, 1.0f);
+        drawText(x + 0.01f * windowWidth, y + 0.01f * windowHeight, maps[i].name.c_str());
+    }
+
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_LIGHTING);
     glEnable(GL_TEXTURE_2D);
@@ -285,11 +413,59 @@ void Renderer::drawWinScreen(int activeMessage) {
     glutSwapBuffers();
 }
 
+void Renderer::drawLoadingScreen(float progress) {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glLoadIdentity();
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, Game::instance->getWindowWidth(), 0, Game::instance->getWindowHeight(), -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glDisable(GL_DEPTH_TEST);
+
+    float windowWidth = Game::instance->getWindowWidth();
+    float windowHeight = Game::instance->getWindowHeight();
+
+    glColor3f(1.0f, 1.0f, 1.0f);
+    drawText(0.4375f * windowWidth, 0.583f * windowHeight, "Loading...");
+
+    glColor3f(0.3f, 0.3f, 0.3f);
+    glBegin(GL_QUADS);
+    glVertex2f(0.25f * windowWidth, 0.458f * windowHeight);
+    glVertex2f(0.75f * windowWidth, 0.458f * windowHeight);
+    glVertex2f(0.75f * windowWidth, 0.541f * windowHeight);
+    glVertex2f(0.25f * windowWidth, 0.541f * windowHeight);
+    glEnd();
+
+    float barEnd = (0.25f + 0.5f * std::min(std::max(progress, 0.0f), 1.0f)) * windowWidth;
+    glColor3f(0.0f, 1.0f, 0.0f);
+    glBegin(GL_QUADS);
+    glVertex2f(0.25f * windowWidth, 0.458f * windowHeight);
+    glVertex2f(barEnd, 0.458f * windowHeight);
+    glVertex2f(barEnd, 0.541f * windowHeight);
+    glVertex2f(0.25f * windowWidth, 0.541f * windowHeight);
+    glEnd();
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_TEXTURE_2D);
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+
+    glutSwapBuffers();
+}
+
 void Renderer::reshape(int w, int h, GameState state) {
     glViewport(0, 0, w, h);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    if (state == GameState::MENU || state == GameState::WIN) {
+    if (state == GameState::MENU || state == GameState::LOADING || state == GameState::WIN) {
         glOrtho(0, w, 0, h, -1, 1);
     } else {
         gluPerspective(45.0f, (float)w / h, 0.1f, 100.0f);
@@ -297,6 +473,18 @@ void Renderer::reshape(int w, int h, GameState state) {
     glMatrixMode(GL_MODELVIEW);
 }
 
+void Renderer::getMapButtonRect(int index, float& x, float& y, float& w, float& h) {
+    // Сетка по 8 кнопок в ряд под кнопками сложности
+    float windowWidth = Game::instance->getWindowWidth();
+    float windowHeight = Game::instance->getWindowHeight();
+    int column = index % 8;
+    int row = index / 8;
+    w = 0.09f * windowWidth;
+    h = 0.04f * windowHeight;
+    x = (0.1f + column * 0.1f) * windowWidth + 0.005f * windowWidth;
+    y = (0.25f - row * 0.05f) * windowHeight;
+}
+
 void Renderer::drawText(float x, float y, const char* text) {
     glRasterPos2f(x, y);
     for (const char* c = text; *c != '\0'; c++) {
@@ -304,102 +492,782 @@ void Renderer::drawText(float x, float y, const char* text) {
     }
 }
 
-void Renderer::drawWall(float x, float z, float width, float height, bool shadowPass) {
-    if (!shadowPass) {
-        glColor3f(1.0f, 1.0f, 1.0f);
-        if (wallTexture) {
-            glBindTexture(GL_TEXTURE_2D, wallTexture);
+void Renderer::appendWallFace(const WallFace& face, std::map<std::tuple<WallSide, float, float>, GLuint>& edges) {
+    bool alongX = face.side == WallSide::NEG_Z || face.side == WallSide::POS_Z;
+    float normal = face.side == WallSide::NEG_Z || face.side == WallSide::NEG_X ? -1.0f : 1.0f;
+    GLfloat nx = alongX ? 0.0f : normal;
+    GLfloat nz = alongX ? normal : 0.0f;
+
+    // Вертикальное ребро - пара вершин (низ, верх). Текстура привязана к миру: u - половина координаты
+    // вдоль грани, поэтому грани одной плоскости из разных кластеров делят рёбра на стыках
+    auto edge = [&](float along) {
+        auto found = edges.emplace(std::make_tuple(face.side, face.plane, along), (GLuint)wallVertices.size());
+        if (found.second) {
+            GLfloat x = alongX ? along : face.plane;
+            GLfloat z = alongX ? face.plane : along;
+            wallVertices.push_back({ along / 2.0f, 0.0f, nx, 0.0f, nz, x, -1.0f, z });
+            wallVertices.push_back({ along / 2.0f, 1.0f, nx, 0.0f, nz, x, 1.0f, z });
+        }
+        return found.first->second;
+    };
+    // Обход тот же, что у граней бокса раньше: низ и верх начала, верх и низ конца
+    GLuint first = edge(face.begin), last = edge(face.end);
+    GLuint quad[6] = { first, first + 1, last + 1, first, last + 1, last };
+    wallIndices.insert(wallIndices.end(), quad, quad + 6);
+}
+
+void Renderer::buildLevelGeometry() {
+    wallVertices.clear();
+    wallIndices.clear();
+
+    buildWallClusters();
+    wallIndexCount = (GLsizei)wallIndices.size();
+
+    if (wallRendering == WallRendering::INSTANCED) {
+        if (!wallInstanceBuffer) {
+            GLExtensions::genBuffers(1, &wallInstanceBuffer);
+        }
+        updateWallInstances();
+    } else if (GLExtensions::hasVertexBufferObjects()) {
+        if (!wallVertexBuffer) {
+            GLExtensions::genBuffers(1, &wallVertexBuffer);
+            GLExtensions::genBuffers(1, &wallIndexBuffer);
+        }
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, wallVertexBuffer);
+        GLExtensions::bufferData(GL_ARRAY_BUFFER, wallVertices.size() * sizeof(WallVertex), wallVertices.data(), GL_STATIC_DRAW);
+        GLExtensions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, wallIndexBuffer);
+        GLExtensions::bufferData(GL_ELEMENT_ARRAY_BUFFER, wallIndices.size() * sizeof(GLuint), wallIndices.data(), GL_STATIC_DRAW);
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+        GLExtensions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        // Данные уже на GPU, копия в памяти не нужна
+        std::vector<WallVertex>().swap(wallVertices);
+        std::vector<GLuint>().swap(wallIndices);
+    }
+
+    if (shadowMode == ShadowMode::LIGHTMAP) {
+        bakeFloorLightmap();
+    } else {
+        buildShadowVolumes();
+    }
+    if (backend == RenderBackend::CORE) {
+        CoreRenderer::buildLevelGeometry();
+    }
+}
+
+void Renderer::buildWallInstancing() {
+    if (!GLExtensions::hasInstancing()) {
+        printf("Отрисовка экземплярами недоступна, стены строятся сеткой\n");
+        wallRendering = WallRendering::MESH;
+        return;
+    }
+    // Конвейер GL 3.3 рисует экземпляры своими шейдерами, отсюда ему нужен только буфер бокса
+    if (backend == RenderBackend::FIXED_FUNCTION) {
+        if (!wallProgram.build(wallVertexShader, wallFragmentShader, { { wallInstanceAttribute, "wall" } })) {
+            printf("Шейдер стен не собран, стены строятся сеткой\n");
+            wallRendering = WallRendering::MESH;
+            return;
+        }
+        GLExtensions::useProgram(wallProgram.getId());
+        GLExtensions::uniform1i(wallProgram.getUniform("wallTexture"), 0);
+        GLExtensions::useProgram(0);
+    }
+
+    // Боковые грани единичного бокса [0, 1] x [-1, 1] x [0, 1] с тем же обходом, что у appendWallFace.
+    // Верх и низ не нужны: камера всегда между полом и верхом стен
+    std::vector<UnitBoxVertex> box;
+    auto addQuad = [&](float nx, float nz, float uAxis, const GLfloat (&corners)[4][4]) {
+        const int order[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i : order) {
+            box.push_back({ corners[i][0], uAxis, nx, 0.0f, nz, corners[i][1], corners[i][2], corners[i][3] });
+        }
+    };
+    addQuad(0.0f, -1.0f, 0.0f, {{0, 0, -1, 0}, {1, 0, 1, 0}, {1, 1, 1, 0}, {0, 1, -1, 0}});
+    addQuad(0.0f, 1.0f, 0.0f, {{0, 0, -1, 1}, {1, 0, 1, 1}, {1, 1, 1, 1}, {0, 1, -1, 1}});
+    addQuad(-1.0f, 0.0f, 1.0f, {{0, 0, -1, 0}, {1, 0, 1, 0}, {1, 0, 1, 1}, {0, 0, -1, 1}});
+    addQuad(1.0f, 0.0f, 1.0f, {{0, 1, -1, 0}, {1, 1, 1, 0}, {1, 1, 1, 1}, {0, 1, -1, 1}});
+    unitBoxVertexCount = (GLsizei)box.size();
+
+    GLExtensions::genBuffers(1, &unitBoxBuffer);
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, unitBoxBuffer);
+    GLExtensions::bufferData(GL_ARRAY_BUFFER, box.size() * sizeof(UnitBoxVertex), box.data(), GL_STATIC_DRAW);
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Renderer::updateWallInstances() {
+    const std::vector<float>& walls = Maze::getInstance().getWalls();
+    if (wallRendering != WallRendering::INSTANCED || walls.size() / 4 != instanceWalls.size()) {
+        buildLevelGeometry();
+        return;
+    }
+
+    // Экземпляры в порядке кластеров, поэтому кластер - непрерывный диапазон буфера
+    std::vector<GLfloat> instances(walls.size());
+    for (size_t k = 0; k < instanceWalls.size(); k++) {
+        std::copy_n(walls.begin() + (size_t)instanceWalls[k] * 4, 4, instances.begin() + k * 4);
+    }
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, wallInstanceBuffer);
+    GLExtensions::bufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(GLfloat), instances.data(), GL_DYNAMIC_DRAW);
+    GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Стены остаются в своих кластерах, сдвигаются только границы
+    const VisibilityGrid& grid = Maze::getInstance().getVisibilityGrid();
+    const float cellSize = VisibilityGrid::cellSize;
+    clusterOverhang = 0.0f;
+    for (size_t cell = 0; cell < clusterOfCell.size(); cell++) {
+        if (clusterOfCell[cell] < 0) {
+            continue;
+        }
+        WallCluster& cluster = wallClusters[clusterOfCell[cell]];
+        cluster.minX = cluster.minZ = INFINITY;
+        cluster.maxX = cluster.maxZ = -INFINITY;
+        for (int k = cluster.firstWall; k < cluster.firstWall + cluster.wallCount; k++) {
+            const GLfloat* wall = instances.data() + (size_t)k * 4;
+            cluster.minX = std::min(cluster.minX, wall[0]);
+            cluster.minZ = std::min(cluster.minZ, wall[1]);
+            cluster.maxX = std::max(cluster.maxX, wall[0] + wall[2]);
+            cluster.maxZ = std::max(cluster.maxZ, wall[1] + wall[3]);
+        }
+        float cellMinX = grid.getOriginX() + (cell % grid.getCols()) * cellSize;
+        float cellMinZ = grid.getOriginZ() + (cell / grid.getCols()) * cellSize;
+        clusterOverhang = std::max({ clusterOverhang, cellMinX - cluster.minX, cellMinZ - cluster.minZ,
+                                     cluster.maxX - (cellMinX + cellSize), cluster.maxZ - (cellMinZ + cellSize) });
+    }
+}
+
+void Renderer::buildWallClusters() {
+    const std::vector<float>& walls = Maze::getInstance().getWalls();
+    const VisibilityGrid& grid = Maze::getInstance().getVisibilityGrid();
+    size_t wallCount = walls.size() / 4;
+    for (const WallCluster& cluster : wallClusters) {
+        if (cluster.query) {
+            GLExtensions::deleteQueries(1, &cluster.query);
+        }
+    }
+    wallClusters.clear();
+    clusterOfCell.clear();
+    instanceWalls.clear();
+    clusterOverhang = 0.0f;
+    if (wallCount == 0) {
+        return;
+    }
+
+    // Кластеры - ячейки сетки видимости уровня: стена относится к ячейке своего центра
+    int cellCount = grid.getCols() * grid.getRows();
+    auto cellOf = [&](size_t i) { return grid.getWallCell(i / 4); };
+
+    // Сортировка подсчётом по ячейкам, затем геометрия кластеров подряд в порядке ячеек
+    std::vector<int> cellStart(cellCount + 1, 0);
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        cellStart[cellOf(i) + 1]++;
+    }
+    for (int cell = 0; cell < cellCount; cell++) {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+    std::vector<int> order(wallCount);
+    std::vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        order[fill[cellOf(i)]++] = (int)(i / 4);
+    }
+
+    // Сетка - только видимые грани, слитые в пределах ячейки; грани идут по возрастанию ячейки
+    bool instanced = wallRendering == WallRendering::INSTANCED;
+    WallMeshBuilder mesh;
+    std::map<std::tuple<WallSide, float, float>, GLuint> edges;
+    size_t nextFace = 0;
+    if (!instanced) {
+        mesh.build(walls, Maze::getInstance().getCollisionGrid(), &grid);
+        wallVertices.reserve(mesh.getFaces().size() * 4);
+        wallIndices.reserve(mesh.getFaces().size() * 6);
+    }
+    clusterOfCell.assign(cellCount, -1);
+    for (int cell = 0; cell < cellCount; cell++) {
+        if (cellStart[cell] == cellStart[cell + 1]) {
+            continue;
+        }
+        WallCluster cluster = { INFINITY, INFINITY, -INFINITY, -INFINITY, (GLsizei)wallIndices.size(), 0,
+                                cellStart[cell], cellStart[cell + 1] - cellStart[cell], 0, -1, false };
+        for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+            size_t i = (size_t)order[k] * 4;
+            if (instanced) {
+                instanceWalls.push_back(order[k]);
+            }
+            cluster.minX = std::min(cluster.minX, walls[i]);
+            cluster.minZ = std::min(cluster.minZ, walls[i + 1]);
+            cluster.maxX = std::max(cluster.maxX, walls[i] + walls[i + 2]);
+            cluster.maxZ = std::max(cluster.maxZ, walls[i + 1] + walls[i + 3]);
+        }
+        const std::vector<WallFace>& faces = mesh.getFaces();
+        for (; !instanced && nextFace < faces.size() && faces[nextFace].cell == cell; nextFace++) {
+            appendWallFace(faces[nextFace], edges);
+        }
+        cluster.indexCount = (GLsizei)wallIndices.size() - cluster.firstIndex;
+
+        const float cellSize = VisibilityGrid::cellSize;
+        float cellMinX = grid.getOriginX() + (cell % grid.getCols()) * cellSize;
+        float cellMinZ = grid.getOriginZ() + (cell / grid.getCols()) * cellSize;
+        clusterOverhang = std::max({ clusterOverhang, cellMinX - cluster.minX, cellMinZ - cluster.minZ,
+                                     cluster.maxX - (cellMinX + cellSize), cluster.maxZ - (cellMinZ + cellSize) });
+        clusterOfCell[cell] = (int)wallClusters.size();
+        wallClusters.push_back(cluster);
+    }
+    if (!instanced) {
+        printf("Сетка стен: %zu вершин, %zu граней (боксами было бы %zu вершин)\n",
+               wallVertices.size(), mesh.getFaces().size(), wallCount * 24);
+    }
+}
+
+void Renderer::drawWalls() {
+    drawnWallCount = 0;
+    culledWallCount = 0;
+    if (wallClusters.empty()) {
+        return;
+    }
+
+    GLfloat projection[16], modelview[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    std::vector<int> visible;
+    float eyeX, eyeZ;
+    collectVisibleClusters(projection, modelview, visible, eyeX, eyeZ);
+    occludedClusterCount = 0;
+    if (occlusionCulling) {
+        occlusionFrame++;
+    }
+    int wallCount = (int)(Maze::getInstance().getWalls().size() / 4);
+    if (visible.empty()) {
+        culledWallCount = wallCount;
+        return;
+    }
+
+    glColor3f(1.0f, 1.0f, 1.0f);
+    if (wallTexture) {
+        glBindTexture(GL_TEXTURE_2D, wallTexture);
+    } else {
+        glColor3f(1.0f, 1.0f, 0.0f);
+    }
+    bool instanced = wallRendering == WallRendering::INSTANCED;
+    if (instanced) {
+        GLExtensions::useProgram(wallProgram.getId());
+        GLExtensions::uniform1i(wallProgram.getUniform("textured"), wallTexture != 0);
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, unitBoxBuffer);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(UnitBoxVertex), (const GLvoid*)offsetof(UnitBoxVertex, v));
+        glNormalPointer(GL_FLOAT, sizeof(UnitBoxVertex), (const GLvoid*)offsetof(UnitBoxVertex, nx));
+        glVertexPointer(3, GL_FLOAT, sizeof(UnitBoxVertex), (const GLvoid*)offsetof(UnitBoxVertex, x));
+        // Указатель экземпляров ставится на каждый диапазон кластеров в drawClusterRange
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, wallInstanceBuffer);
+        GLExtensions::enableVertexAttribArray(wallInstanceAttribute);
+        GLExtensions::vertexAttribDivisor(wallInstanceAttribute, 1);
+    } else if (wallVertexBuffer) {
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, wallVertexBuffer);
+        GLExtensions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, wallIndexBuffer);
+        glInterleavedArrays(GL_T2F_N3F_V3F, 0, nullptr);
+    } else {
+        glInterleavedArrays(GL_T2F_N3F_V3F, 0, wallVertices.data());
+    }
+
+    if (occlusionCulling) {
+        drawOcclusionCulled(visible, eyeX, eyeZ);
+    } else {
+        // Кластеры с соседними номерами лежат в буфере подряд - диапазоны склеиваются.
+        // Если видны все, на все стены уходит один вызов
+        int first = visible[0];
+        for (size_t k = 0; k < visible.size(); k++) {
+            drawnWallCount += wallClusters[visible[k]].wallCount;
+            if (k + 1 == visible.size() || visible[k + 1] != visible[k] + 1) {
+                drawClusterRange(first, visible[k]);
+                first = k + 1 < visible.size() ? visible[k + 1] : 0;
+            }
+        }
+    }
+    culledWallCount = wallCount - drawnWallCount;
+
+    if (instanced) {
+        GLExtensions::vertexAttribDivisor(wallInstanceAttribute, 0);
+        GLExtensions::disableVertexAttribArray(wallInstanceAttribute);
+        GLExtensions::useProgram(0);
+    }
+    if (wallVertexBuffer || instanced) {
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+        GLExtensions::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Renderer::collectVisibleClusters(const GLfloat* projection, const GLfloat* modelview, std::vector<int>& visible,
+                                      float& eyeX, float& eyeZ) {
+    // Плоскости пирамиды видимости из матрицы проекции * вида (метод Gribb-Hartmann): ax + by + cz + d >= 0.
+    // Дальняя плоскость заменена плоскостью конца тумана: за ней всё равно только цвет тумана
+    GLfloat clip[16];
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            clip[col * 4 + row] = 0.0f;
+            for (int k = 0; k < 4; k++) {
+                clip[col * 4 + row] += projection[k * 4 + row] * modelview[col * 4 + k];
+            }
+        }
+    }
+    float planes[6][4];
+    for (int axis = 0; axis < 3; axis++) {
+        for (int k = 0; k < 4; k++) {
+            planes[axis * 2][k] = clip[k * 4 + 3] + clip[k * 4 + axis];
+            planes[axis * 2 + 1][k] = clip[k * 4 + 3] - clip[k * 4 + axis];
+        }
+    }
+    // Глубина -z в системе камеры не больше fogEnd: z + fogEnd >= 0
+    for (int k = 0; k < 4; k++) {
+        planes[5][k] = modelview[k * 4 + 2];
+    }
+    planes[5][3] += fogEnd;
+
+    auto isClusterVisible = [&](const WallCluster& cluster) {
+        for (const float* plane : planes) {
+            // Вершина бокса, дальше всех продвинутая вдоль нормали плоскости
+            float x = plane[0] >= 0.0f ? cluster.maxX : cluster.minX;
+            float y = plane[1] >= 0.0f ? 1.0f : -1.0f;
+            float z = plane[2] >= 0.0f ? cluster.maxZ : cluster.minZ;
+            if (plane[0] * x + plane[1] * y + plane[2] * z + plane[3] < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Обходятся только ячейки под пирамидой, усечённой на fogEnd: её след на полу покрывают
+    // камера и четыре дальних угла. Оси камеры - строки матрицы вида
+    eyeX = -(modelview[0] * modelview[12] + modelview[1] * modelview[13] + modelview[2] * modelview[14]);
+    eyeZ = -(modelview[8] * modelview[12] + modelview[9] * modelview[13] + modelview[10] * modelview[14]);
+    float tanX = 1.0f / projection[0], tanY = 1.0f / projection[5];
+    float footMinX = eyeX, footMaxX = eyeX, footMinZ = eyeZ, footMaxZ = eyeZ;
+    for (float sx : { -1.0f, 1.0f }) {
+        for (float sy : { -1.0f, 1.0f }) {
+            // Угол в системе камеры (sx·tanX·d, sy·tanY·d, -d) переводится в мир транспонированной матрицей
+            float cx = sx * tanX * fogEnd, cy = sy * tanY * fogEnd, cz = -fogEnd;
+            float x = eyeX + modelview[0] * cx + modelview[1] * cy + modelview[2] * cz;
+            float z = eyeZ + modelview[8] * cx + modelview[9] * cy + modelview[10] * cz;
+            footMinX = std::min(footMinX, x);
+            footMaxX = std::max(footMaxX, x);
+            footMinZ = std::min(footMinZ, z);
+            footMaxZ = std::max(footMaxZ, z);
+        }
+    }
+    const VisibilityGrid& grid = Maze::getInstance().getVisibilityGrid();
+    const float cellSize = VisibilityGrid::cellSize;
+    int col0 = std::max(0, (int)std::floor((footMinX - clusterOverhang - grid.getOriginX()) / cellSize));
+    int col1 = std::min(grid.getCols() - 1, (int)std::floor((footMaxX + clusterOverhang - grid.getOriginX()) / cellSize));
+    int row0 = std::max(0, (int)std::floor((footMinZ - clusterOverhang - grid.getOriginZ()) / cellSize));
+    int row1 = std::min(grid.getRows() - 1, (int)std::floor((footMaxZ + clusterOverhang - grid.getOriginZ()) / cellSize));
+
+    // Из ячейки камеры рисуются только кластеры её PVS и ближние (pvsNearDistance). Вне сетки, без PVS или если дальние углы
+    // пирамиды дальше радиуса PVS (очень широкое окно) - все, что прошли проверку пирамидой
+    float farCornerDistance = fogEnd * std::sqrt(1.0f + tanX * tanX + tanY * tanY);
+    int eyeCell = grid.hasPVS() && farCornerDistance <= grid.getRange() ? grid.cellAt(eyeX, eyeZ) : -1;
+
+    auto isClusterNear = [&](const WallCluster& cluster) {
+        float dx = std::max({ cluster.minX - eyeX, 0.0f, eyeX - cluster.maxX });
+        float dz = std::max({ cluster.minZ - eyeZ, 0.0f, eyeZ - cluster.maxZ });
+        return dx * dx + dz * dz <= pvsNearDistance * pvsNearDistance;
+    };
+
+    for (int row = row0; row <= row1; row++) {
+        for (int col = col0; col <= col1; col++) {
+            int cell = row * grid.getCols() + col;
+            int index = clusterOfCell[cell];
+            if (index >= 0 && (eyeCell < 0 || grid.isVisible(eyeCell, cell) || isClusterNear(wallClusters[index]))
+                && isClusterVisible(wallClusters[index])) {
+                visible.push_back(index);
+            }
+        }
+    }
+}
+
+
+void Renderer::drawClusterRange(int firstCluster, int lastCluster) {
+    const WallCluster& first = wallClusters[firstCluster];
+    const WallCluster& last = wallClusters[lastCluster];
+    if (wallRendering == WallRendering::INSTANCED) {
+        // Боковые грани единичного бокса на каждый экземпляр диапазона
+        GLExtensions::vertexAttribPointer(wallInstanceAttribute, 4, GL_FLOAT, GL_FALSE, 0,
+                                          (const GLvoid*)(first.firstWall * 4 * sizeof(GLfloat)));
+        GLExtensions::drawArraysInstanced(GL_TRIANGLES, 0, unitBoxVertexCount, last.firstWall + last.wallCount - first.firstWall);
+        return;
+    }
+    GLsizei indexCount = last.firstIndex + last.indexCount - first.firstIndex;
+    if (wallVertexBuffer) {
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (const GLvoid*)(first.firstIndex * sizeof(GLuint)));
+    } else {
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, wallIndices.data() + first.firstIndex);
+    }
+}
+
+void Renderer::drawOcclusionCulled(std::vector<int>& clusters, float eyeX, float eyeZ) {
+    // Спереди назад: ближние стены заполняют буфер глубины раньше, чем проверяются дальние
+    auto distanceSquared = [&](const WallCluster& cluster) {
+        float dx = std::max({ cluster.minX - eyeX, 0.0f, eyeX - cluster.maxX });
+        float dz = std::max({ cluster.minZ - eyeZ, 0.0f, eyeZ - cluster.maxZ });
+        return dx * dx + dz * dz;
+    };
+    std::sort(clusters.begin(), clusters.end(), [&](int a, int b) {
+        return distanceSquared(wallClusters[a]) < distanceSquared(wallClusters[b]);
+    });
+
+    // Годен только результат прошлого кадра (occlusionFrame растёт в drawWalls): более старый
+    // снят с другой точки, и кластер, вернувшийся в пирамиду, по нему пропускать нельзя
+    std::vector<int> candidates;
+    for (int index : clusters) {
+        WallCluster& cluster = wallClusters[index];
+        if (cluster.query == 0) {
+            GLExtensions::genQueries(1, &cluster.query);
+        }
+        // Результат берём, только если он готов: ждать GPU ради него незачем. Пока его нет,
+        // кластер рисуется, а запрос выдаётся заново
+        bool occluded = false;
+        if (cluster.queryFrame == occlusionFrame - 1) {
+            GLuint available = 0;
+            GLExtensions::getQueryObjectuiv(cluster.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint samples = 0;
+                GLExtensions::getQueryObjectuiv(cluster.query, GL_QUERY_RESULT, &samples);
+                occluded = samples == 0;
+                // Бокс не прошёл - в прошлом кадре условная отрисовка кластер пропустила
+                // (без неё пропуск уже посчитан в том кадре)
+                if (occluded && cluster.boxQuery && GLExtensions::hasConditionalRender()) {
+                    occludedClusterCount++;
+                }
+            }
+        }
+        if (occluded && distanceSquared(cluster) > occlusionNearMargin * occlusionNearMargin) {
+            candidates.push_back(index);
         } else {
-            glColor3f(1.0f, 1.0f, 0.0f);
+            drawClusterWithQuery(index);
         }
     }
+    if (candidates.empty()) {
+        return;
+    }
 
-    glBegin(GL_QUADS);
+    // Перекрытые в прошлом кадре проверяются боксом по буферу глубины этого кадра, так что
+    // открывшийся кластер рисуется в том же кадре. С условной отрисовкой (GL 3.0) по ответу
+    // решает GPU, и CPU его не ждёт. Без неё ответы читаются сразу - одно ожидание GPU на кадр,
+    // после того как выданы все боксы
+    bool instanced = wallRendering == WallRendering::INSTANCED;
+    if (instanced) {
+        GLExtensions::useProgram(0);
+    }
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDepthFunc(GL_LEQUAL);
+    for (int index : candidates) {
+        WallCluster& cluster = wallClusters[index];
+        GLExtensions::beginQuery(GL_SAMPLES_PASSED, cluster.query);
+        drawClusterBox(cluster);
+        GLExtensions::endQuery(GL_SAMPLES_PASSED);
+        cluster.queryFrame = occlusionFrame;
+        cluster.boxQuery = true;
+    }
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+    if (instanced) {
+        GLExtensions::useProgram(wallProgram.getId());
+    }
 
-    glNormal3f(0.0f, 0.0f, -1.0f);
-    glTexCoord2f(0.0f, 0.0f); glVertex3f(x, -1.0f, z);
-    glTexCoord2f(0.0f, 1.0f); glVertex3f(x,  1.0f, z);
-    glTexCoord2f(width / 2.0f, 1.0f); glVertex3f(x + width,  1.0f, z);
-    glTexCoord2f(width / 2.0f, 0.0f); glVertex3f(x + width, -1.0f, z);
-
-    glNormal3f(0.0f, 0.0f, 1.0f);
-    glTexCoord2f(0.0f, 0.0f); glVertex3f(x, -1.0f, z + height);
-    glTexCoord2f(0.0f, 1.0f); glVertex3f(x,  1.0f, z + height);
-    glTexCoord2f(width / 2.0f, 1.0f); glVertex3f(x + width,  1.0f, z + height);
-    glTexCoord2f(width / 2.0f, 0.0f); glVertex3f(x + width, -1.0f, z + height);
-
-    glNormal3f(-1.0f, 0.0f, 0.0f);
-    glTexCoord2f(0.0f, 0.0f); glVertex3f(x, -1.0f, z);
-    glTexCoord2f(0.0f, 1.0f); glVertex3f(x,  1.0f, z);
-    glTexCoord2f(height / 2.0f, 1.0f); glVertex3f(x,  1.0f, z + height);
-    glTexCoord2f(height / 2.0f, 0.0f); glVertex3f(x, -1.0f, z + height);
-
-    glNormal3f(1.0f, 0.0f, 0.0f);
-    glTexCoord2f(0.0f, 0.0f); glVertex3f(x + width, -1.0f, z);
-    glTexCoord2f(0.0f, 1.0f); glVertex3f(x + width,  1.0f, z);
-    glTexCoord2f(height / 2.0f, 1.0f); glVertex3f(x + width,  1.0f, z + height);
-    glTexCoord2f(height / 2.0f, 0.0f); glVertex3f(x + width, -1.0f, z + height);
-
-    glNormal3f(0.0f, -1.0f, 0.0f);
-    glTexCoord2f(0.0f, 0.0f); glVertex3f(x, -1.0f, z);
-    glTexCoord2f(width / 2.0f, 0.0f); glVertex3f(x + width, -1.0f, z);
-    glTexCoord2f(width / 2.0f, height / 2.0f); glVertex3f(x + width, -1.0f, z + height);
-    glTexCoord2f(0.0f, height / 2.0f); glVertex3f(x, -1.0f, z + height);
+    if (GLExtensions::hasConditionalRender()) {
+        for (int index : candidates) {
+            GLExtensions::beginConditionalRender(wallClusters[index].query, GL_QUERY_WAIT);
+            drawClusterRange(index, index);
+            GLExtensions::endConditionalRender();
+            drawnWallCount += wallClusters[index].wallCount;
+        }
+        return;
+    }
+    for (int index : candidates) {
+        WallCluster& cluster = wallClusters[index];
+        GLuint samples = 0;
+        GLExtensions::getQueryObjectuiv(cluster.query, GL_QUERY_RESULT, &samples);
+        if (samples == 0) {
+            occludedClusterCount++;
+            continue;
+        }
+        drawClusterWithQuery(index);
+    }
+}
 
-    glNormal3f(0.0f, 1.0f, 0.0f);
-    glTexCoord2f(0.0f, 0.0f); glVertex3f(x,  1.0f, z);
-    glTexCoord2f(width / 2.0f, 0.0f); glVertex3f(x + width,  1.0f, z);
-    glTexCoord2f(width / 2.0f, height / 2.0f); glVertex3f(x + width,  1.0f, z + height);
-    glTexCoord2f(0.0f, height / 2.0f); glVertex3f(x,  1.0f, z + height);
+void Renderer::drawClusterWithQuery(int index) {
+    WallCluster& cluster = wallClusters[index];
+    GLExtensions::beginQuery(GL_SAMPLES_PASSED, cluster.query);
+    drawClusterRange(index, index);
+    GLExtensions::endQuery(GL_SAMPLES_PASSED);
+    cluster.queryFrame = occlusionFrame;
+    cluster.boxQuery = false;
+    drawnWallCount += cluster.wallCount;
+}
 
+void Renderer::drawClusterBox(const WallCluster& cluster) {
+    // Все шесть граней: отсечение нелицевых граней выключено, годится и задняя
+    const float x[2] = { cluster.minX, cluster.maxX };
+    const float y[2] = { -1.0f, 1.0f };
+    const float z[2] = { cluster.minZ, cluster.maxZ };
+    glBegin(GL_QUADS);
+    for (int side = 0; side < 2; side++) {
+        glVertex3f(x[side], y[0], z[0]); glVertex3f(x[side], y[1], z[0]); glVertex3f(x[side], y[1], z[1]); glVertex3f(x[side], y[0], z[1]);
+        glVertex3f(x[0], y[side], z[0]); glVertex3f(x[1], y[side], z[0]); glVertex3f(x[1], y[side], z[1]); glVertex3f(x[0], y[side], z[1]);
+        glVertex3f(x[0], y[0], z[side]); glVertex3f(x[1], y[0], z[side]); glVertex3f(x[1], y[1], z[side]); glVertex3f(x[0], y[1], z[side]);
+    }
     glEnd();
+}
 
-    if (!shadowPass) {
-        glBindTexture(GL_TEXTURE_2D, 0);
+void Renderer::buildShadowVolumes() {
+    shadowVertices.clear();
+
+    // Объём - отрезки от верхних рёбер стен (y = 1) до их проекции из lightPos на пол. Строится
+    // по внешнему контуру всех стен: рёбра внутри слитых боксов и совпадающие рёбра соседей
+    // дали бы лишние, взаимно гасящие слои в стенсиле
+    const Maze& maze = Maze::getInstance();
+    const std::vector<float>& walls = maze.getWalls();
+    const CollisionGrid& grid = maze.getCollisionGrid();
+    WallMeshBuilder outline;
+    outline.build(walls, grid, nullptr);
+
+    // Камера всегда на высоте Player::getY(), и луч от неё к полу пересекает объём только ниже
+    // этой высоты: грани строятся от capY. Отступ вниз больше, чем поднимается пирамида перед
+    // ближней плоскостью отсечения (0.1 * tg 22.5°, камера не наклоняется), так что z-pass не
+    // теряет пересечений рядом с камерой. Начальное число для z-pass - попал ли луч на высоте
+    // capY в объём - дают крышки: сечения объёмов боксов, которые выставляют стенсил в 1
+    float shadowY = -1.0f;
+    float capY = Player::getY() - 0.1f;
+    float t = (1.0f - shadowY) / (lightPos[1] - shadowY);
+    float tCap = t * (1.0f - capY) / (1.0f - shadowY);
+    shadowVertices.reserve((walls.size() / 4 + outline.getFaces().size()) * 18);
+    for (size_t i = 0; i + 3 < walls.size(); i += 4) {
+        float x[2], z[2];
+        for (int corner = 0; corner < 2; corner++) {
+            float cornerX = walls[i] + walls[i + 2] * corner;
+            float cornerZ = walls[i + 1] + walls[i + 3] * corner;
+            x[corner] = cornerX + (lightPos[0] - cornerX) * tCap;
+            z[corner] = cornerZ + (lightPos[2] - cornerZ) * tCap;
+        }
+        const GLfloat cap[6][3] = {
+            { x[0], capY, z[0] }, { x[0], capY, z[1] }, { x[1], capY, z[1] },
+            { x[0], capY, z[0] }, { x[1], capY, z[1] }, { x[1], capY, z[0] }
+        };
+        for (const GLfloat* vertex : cap) {
+            shadowVertices.insert(shadowVertices.end(), vertex, vertex + 3);
+        }
+    }
+    shadowCapVertexCount = (GLsizei)(shadowVertices.size() / 3);
+
+    for (const WallFace& edge : outline.getFaces()) {
+        bool alongX = edge.side == WallSide::NEG_Z || edge.side == WallSide::POS_Z;
+        float lightAcross = alongX ? lightPos[2] : lightPos[0];
+        float lightAlong = alongX ? lightPos[0] : lightPos[2];
+        bool outwardNegative = edge.side == WallSide::NEG_Z || edge.side == WallSide::NEG_X;
+        bool facesLight = outwardNegative ? lightAcross < edge.plane : lightAcross > edge.plane;
+
+        // Лицевая сторона - наружу: обход от begin к end у граней -Z и +X, обратный у +Z и -X
+        bool reversed = edge.side == WallSide::POS_Z || edge.side == WallSide::NEG_X;
+        float ends[2] = { reversed ? edge.end : edge.begin, reversed ? edge.begin : edge.end };
+        // Точки ребра, сдвинутые к свету на долю s (в координатах вдоль ребра и поперёк него)
+        GLfloat corners[4][3];
+        auto setCorner = [&](int corner, float along, float s, float y) {
+            float a = along + (lightAlong - along) * s;
+            float c = edge.plane + (lightAcross - edge.plane) * s;
+            corners[corner][0] = alongX ? a : c;
+            corners[corner][1] = y;
+            corners[corner][2] = alongX ? c : a;
+        };
+        setCorner(0, ends[0], tCap, capY);
+        setCorner(1, ends[1], tCap, capY);
+        setCorner(2, ends[1], t, shadowY);
+        setCorner(3, ends[0], t, shadowY);
+
+        // Грань у ребра, отвёрнутого от света, уходит под стену. Если она целиком внутри одного
+        // бокса, луч к видимому полу её не пересекает
+        if (!facesLight) {
+            float minX = INFINITY, minZ = INFINITY, maxX = -INFINITY, maxZ = -INFINITY;
+            for (const GLfloat* corner : corners) {
+                minX = std::min(minX, corner[0]);
+                minZ = std::min(minZ, corner[2]);
+                maxX = std::max(maxX, corner[0]);
+                maxZ = std::max(maxZ, corner[2]);
+            }
+            bool hidden = grid.visit(minX, minZ, maxX, maxZ, [&](int box) {
+                const float* wall = walls.data() + (size_t)box * 4;
+                return wall[0] <= minX && wall[1] <= minZ && wall[0] + wall[2] >= maxX && wall[1] + wall[3] >= maxZ;
+            });
+            if (hidden) {
+                continue;
+            }
+        }
+
+        // Четырёхугольник (a, b, c, d) -> треугольники (a, b, c) и (a, c, d) с тем же обходом
+        const int order[6] = { 0, 1, 2, 0, 2, 3 };
+        for (int i : order) {
+            shadowVertices.insert(shadowVertices.end(), corners[i], corners[i] + 3);
+        }
+    }
+    shadowVertexCount = (GLsizei)(shadowVertices.size() / 3);
+    for (int i = 0; i < 3; i++) {
+        shadowLightPos[i] = lightPos[i];
     }
+
+    if (GLExtensions::hasVertexBufferObjects()) {
+        if (!shadowVertexBuffer) {
+            GLExtensions::genBuffers(1, &shadowVertexBuffer);
+        }
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, shadowVertexBuffer);
+        GLExtensions::bufferData(GL_ARRAY_BUFFER, shadowVertices.size() * sizeof(GLfloat), shadowVertices.data(), GL_STATIC_DRAW);
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+        std::vector<GLfloat>().swap(shadowVertices);
+    }
+}
+
+void Renderer::drawShadowVolumes() {
+    if (shadowVertexBuffer) {
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, shadowVertexBuffer);
+        glVertexPointer(3, GL_FLOAT, 0, nullptr);
+    } else {
+        glVertexPointer(3, GL_FLOAT, 0, shadowVertices.data());
+    }
+    glEnableClientState(GL_VERTEX_ARRAY);
+    countShadowVolumes();
+    glDisableClientState(GL_VERTEX_ARRAY);
+    if (shadowVertexBuffer) {
+        GLExtensions::bindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
+void Renderer::countShadowVolumes() {
+    // Крышки перекрываются у соседних боксов, поэтому не прибавляют, а выставляют 1
+    glDisable(GL_CULL_FACE);
+    glStencilFunc(GL_ALWAYS, 1, ~0);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    glDrawArrays(GL_TRIANGLES, 0, shadowCapVertexCount);
+    glEnable(GL_CULL_FACE);
+
+    GLsizei sideVertexCount = shadowVertexCount - shadowCapVertexCount;
+    glCullFace(GL_BACK);
+    glStencilFunc(GL_ALWAYS, 0, ~0);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+    glDrawArrays(GL_TRIANGLES, shadowCapVertexCount, sideVertexCount);
+
+    glCullFace(GL_FRONT);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_DECR);
+    glDrawArrays(GL_TRIANGLES, shadowCapVertexCount, sideVertexCount);
 }
 
-void Renderer::drawShadowVolume(float x, float z, float width, float height) {
+void Renderer::bakeFloorLightmap() {
+    const float texelsPerUnit = 16.0f;
+    const unsigned char lit = 255;
+    const unsigned char shadowed = 128;  // Как затемняющий квад с альфой 0.5 в стенсильном режиме
+
+    float mazeWidth = Maze::getInstance().getWidth();
+    float mazeHeight = Maze::getInstance().getHeight();
+
+    GLint maxTextureSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    auto textureSize = [&](float extent) {
+        int size = 1;
+        while (size < extent * texelsPerUnit && size < maxTextureSize) {
+            size *= 2;
+        }
+        return size;
+    };
+    int texWidth = textureSize(mazeWidth);
+    int texHeight = textureSize(mazeHeight);
+    for (int i = 0; i < 3; i++) {
+        shadowLightPos[i] = lightPos[i];
+    }
+
+    // Тень стены на полу - проекция её верхней грани из lightPos, как у объёма в drawShadowVolumes
     float shadowY = -1.0f;
-    float lightY = lightPos[1];
-    float lightX = lightPos[0];
-    float lightZ = lightPos[2];
+    float t = (1.0f - shadowY) / (lightPos[1] - shadowY);
+    const std::vector<float>& walls = Maze::getInstance().getWalls();
+    std::vector<float> shadowRects;
+    shadowRects.reserve(walls.size());
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        float x1 = walls[i] + (lightPos[0] - walls[i]) * t;
+        float x2 = (walls[i] + walls[i + 2]) + (lightPos[0] - (walls[i] + walls[i + 2])) * t;
+        float z1 = walls[i + 1] + (lightPos[2] - walls[i + 1]) * t;
+        float z2 = (walls[i + 1] + walls[i + 3]) + (lightPos[2] - (walls[i + 1] + walls[i + 3])) * t;
+        shadowRects.push_back(std::min(x1, x2));
+        shadowRects.push_back(std::min(z1, z2));
+        shadowRects.push_back(std::max(x1, x2));
+        shadowRects.push_back(std::max(z1, z2));
+    }
 
-    glBegin(GL_QUADS);
+    // Каждый поток заполняет свою полосу строк текстуры
+    std::vector<unsigned char> pixels((size_t)texWidth * texHeight, lit);
+    auto bakeRows = [&](int rowBegin, int rowEnd) {
+        for (size_t i = 0; i < shadowRects.size(); i += 4) {
+            int col0 = std::max(0, (int)std::ceil((shadowRects[i] + mazeWidth / 2) / mazeWidth * texWidth - 0.5f));
+            int col1 = std::min(texWidth - 1, (int)std::floor((shadowRects[i + 2] + mazeWidth / 2) / mazeWidth * texWidth - 0.5f));
+            int row0 = std::max(rowBegin, (int)std::ceil((shadowRects[i + 1] + mazeHeight / 2) / mazeHeight * texHeight - 0.5f));
+            int row1 = std::min(rowEnd - 1, (int)std::floor((shadowRects[i + 3] + mazeHeight / 2) / mazeHeight * texHeight - 0.5f));
+            // Прямоугольник уже текселя или целиком за краем текстуры не накрывает ни одного центра
+            if (col1 < col0 || row1 < row0) {
+                continue;
+            }
+            for (int row = row0; row <= row1; row++) {
+                std::fill(pixels.begin() + (size_t)row * texWidth + col0, pixels.begin() + (size_t)row * texWidth + col1 + 1, shadowed);
+            }
+        }
+    };
 
-    glVertex3f(x, 1.0f, z);
-    glVertex3f(x + width, 1.0f, z);
-    float projX1 = x + (lightX - x) * (1.0f - shadowY) / (lightY - shadowY);
-    float projX2 = (x + width) + (lightX - (x + width)) * (1.0f - shadowY) / (lightY - shadowY);
-    float projZ = z + (lightZ - z) * (1.0f - shadowY) / (lightY - shadowY);
-    glVertex3f(projX2, shadowY, projZ);
-    glVertex3f(projX1, shadowY, projZ);
-
-    glVertex3f(x, 1.0f, z + height);
-    glVertex3f(x + width, 1.0f, z + height);
-    projX1 = x + (lightX - x) * (1.0f - shadowY) / (lightY - shadowY);
-    projX2 = (x + width) + (lightX - (x + width)) * (1.0f - shadowY) / (lightY - shadowY);
-    projZ = (z + height) + (lightZ - (z + height)) * (1.0f - shadowY) / (lightY - shadowY);
-    glVertex3f(projX2, shadowY, projZ);
-    glVertex3f(projX1, shadowY, projZ);
-
-    glVertex3f(x, 1.0f, z);
-    glVertex3f(x, 1.0f, z + height);
-    projX1 = x + (lightX - x) * (1.0f - shadowY) / (lightY - shadowY);
-    projZ = z + (lightZ - z) * (1.0f - shadowY) / (lightY - shadowY);
-    float projZ2 = (z + height) + (lightZ - (z + height)) * (1.0f - shadowY) / (lightY - shadowY);
-    glVertex3f(projX1, shadowY, projZ2);
-    glVertex3f(projX1, shadowY, projZ);
-
-    glVertex3f(x + width, 1.0f, z);
-    glVertex3f(x + width, 1.0f, z + height);
-    projX2 = (x + width) + (lightX - (x + width)) * (1.0f - shadowY) / (lightY - shadowY);
-    projZ = z + (lightZ - z) * (1.0f - shadowY) / (lightY - shadowY);
-    projZ2 = (z + height) + (lightZ - (z + height)) * (1.0f - shadowY) / (lightY - shadowY);
-    glVertex3f(projX2, shadowY, projZ2);
-    glVertex3f(projX2, shadowY, projZ);
+    parallelBands(texHeight, parallelBandCount(texHeight), [&](int, int rowBegin, int rowEnd) {
+        bakeRows(rowBegin, rowEnd);
+    });
 
-    glEnd();
+    if (!lightmapTexture) {
+        glGenTextures(1, &lightmapTexture);
+    }
+    glBindTexture(GL_TEXTURE_2D, lightmapTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    // В профиле core нет GL_LUMINANCE; шейдеры CoreRenderer читают яркость из красного канала
+    GLenum format = backend == RenderBackend::CORE ? GL_RED : GL_LUMINANCE;
+    glTexImage2D(GL_TEXTURE_2D, 0, format, texWidth, texHeight, 0, format, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Renderer::enableFloorLightmap() {
+    float mazeWidth = Maze::getInstance().getWidth();
+    float mazeHeight = Maze::getInstance().getHeight();
+    // Координаты карты освещения генерируются из мировых x и z пола
+    GLfloat planeS[] = { 1.0f / mazeWidth, 0.0f, 0.0f, 0.5f };
+    GLfloat planeT[] = { 0.0f, 0.0f, 1.0f / mazeHeight, 0.5f };
+
+    GLExtensions::activeTexture(GL_TEXTURE1);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, lightmapTexture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glTexGeni(GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
+    glTexGeni(GL_T, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
+    glTexGenfv(GL_S, GL_OBJECT_PLANE, planeS);
+    glTexGenfv(GL_T, GL_OBJECT_PLANE, planeT);
+    glEnable(GL_TEXTURE_GEN_S);
+    glEnable(GL_TEXTURE_GEN_T);
+    GLExtensions::activeTexture(GL_TEXTURE0);
+}
+
+void Renderer::disableFloorLightmap() {
+    GLExtensions::activeTexture(GL_TEXTURE1);
+    glDisable(GL_TEXTURE_GEN_S);
+    glDisable(GL_TEXTURE_GEN_T);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+    GLExtensions::activeTexture(GL_TEXTURE0);
 }
 
 void Renderer::drawExit(float x, float y, float z) {
@@ -432,31 +1300,35 @@ void Renderer::drawMiniMap() {
     float mapY = -0.165f * windowHeight / Maze::getInstance().getHeight(); 
 
     glColor3f(1.0f, 1.0f, 1.0f);
-    const std::vector<float>& walls = Maze::getInstance().getWalls();
-    for (size_t i = 0; i < walls.size(); i += 4) {
-        float x = walls[i] * mapScale + 0.125f * windowWidth;
-        float z = (Maze::getInstance().getHeight() - walls[i + 1]) * mapScale + mapY;
-        float w = walls[i + 2] * mapScale;
-        float h = walls[i + 3] * mapScale;
-        glBegin(GL_QUADS);
-        glVertex2f(x, z);
-        glVertex2f(x + w, z);
-        glVertex2f(x + w, z - h);
-        glVertex2f(x, z - h);
-        glEnd();
+    const WallBoxes& boxes = Maze::getInstance().getWallBoxes();
+    const float* minX = boxes.getMinX();
+    const float* minZ = boxes.getMinZ();
+    const float* maxX = boxes.getMaxX();
+    const float* maxZ = boxes.getMaxZ();
+    float offsetX = 0.125f * windowWidth;
+    float offsetZ = Maze::getInstance().getHeight() * mapScale + mapY;
+    glBegin(GL_QUADS);
+    for (size_t i = 0; i < boxes.size(); i++) {
+        float x1 = minX[i] * mapScale + offsetX, x2 = maxX[i] * mapScale + offsetX;
+        float z1 = offsetZ - minZ[i] * mapScale, z2 = offsetZ - maxZ[i] * mapScale;
+        glVertex2f(x1, z1);
+        glVertex2f(x2, z1);
+        glVertex2f(x2, z2);
+        glVertex2f(x1, z2);
     }
+    glEnd();
 
     glColor3f(0.0f, 1.0f, 0.0f);
-    float playerX = Player::getX() * mapScale + 0.125f * windowWidth;
-    float playerZ = (Maze::getInstance().getHeight() - Player::getZ()) * mapScale + mapY;
+    float playerX = Player::getRenderX() * mapScale + 0.125f * windowWidth;
+    float playerZ = (Maze::getInstance().getHeight() - Player::getRenderZ()) * mapScale + mapY;
     float arrowSize = 0.0125f * windowWidth;  // 10 при 800
 
-    float tipX = playerX + arrowSize * sin(Player::getAngle());
-    float tipZ = playerZ - arrowSize * cos(Player::getAngle());
-    float base1X = playerX + arrowSize * 0.5f * sin(Player::getAngle() + 2.5f);
-    float base1Z = playerZ - arrowSize * 0.5f * cos(Player::getAngle() + 2.5f);
-    float base2X = playerX + arrowSize * 0.5f * sin(Player::getAngle() - 2.5f);
-    float base2Z = playerZ - arrowSize * 0.5f * cos(Player::getAngle() - 2.5f);
+    float tipX = playerX + arrowSize * sin(Player::getRenderAngle());
+    float tipZ = playerZ - arrowSize * cos(Player::getRenderAngle());
+    float base1X = playerX + arrowSize * 0.5f * sin(Player::getRenderAngle() + 2.5f);
+    float base1Z = playerZ - arrowSize * 0.5f * cos(Player::getRenderAngle() + 2.5f);
+    float base2X = playerX + arrowSize * 0.5f * sin(Player::getRenderAngle() - 2.5f);
+    float base2Z = playerZ - arrowSize * 0.5f * cos(Player::getRenderAngle() - 2.5f);
 
     glBegin(GL_TRIANGLES);
     glVertex2f(tipX, tipZ);
@@ -464,6 +1336,14 @@ void Renderer::drawMiniMap() {
     glVertex2f(base2X, base2Z);
     glEnd();
 
+    char stats[64];
+    snprintf(stats, sizeof(stats), "Walls: %d drawn, %d culled", drawnWallCount, culledWallCount);
+    drawText(0.01f * windowWidth, 0.97f * windowHeight, stats);
+    if (occlusionCulling) {
+        snprintf(stats, sizeof(stats), "Occlusion: %d clusters skipped", occludedClusterCount);
+        drawText(0.01f * windowWidth, 0.94f * windowHeight, stats);
+    }
+
     glColor3f(1.0f, 0.0f, 0.0f);
     float exitMapX = Maze::getInstance().getExitX() * mapScale + 0.125f * windowWidth;
     float exitMapZ = (Maze::getInstance().getHeight() - Maze::getInstance().getExitZ()) * mapScale + mapY;
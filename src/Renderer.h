@@ -3,27 +3,146 @@
 
 #include <GL/freeglut.h>
 #include <string>  // Добавлено
+#include <vector>
+#include <map>
+#include <tuple>
 #include "Game.h"
+#include "ShaderProgram.h"
+#include "TextureManager.h"
+#include "WallMeshBuilder.h"
+
+// Тени на полу: стенсильные объёмы каждый кадр или карта освещения, запекаемая при загрузке уровня
+enum class ShadowMode { STENCIL, LIGHTMAP };
+
+// Стены: готовая сетка видимых граней (WallMeshBuilder) или один единичный бокс, размножаемый по экземплярам (x, z, w, h)
+enum class WallRendering { MESH, INSTANCED };
+
+// Конвейер отрисовки сцены: фиксированный OpenGL 1.x или шейдеры GL 3.3 core (CoreRenderer)
+enum class RenderBackend { FIXED_FUNCTION, CORE };
 
 class Renderer {
 public:
     static void initialize();
-    static void loadTexture(const std::string& filename, GLuint& textureID);
+    // decoded - файл, заранее декодированный TextureManager::decode (например, в потоке загрузки)
+    static void loadTexture(const std::string& filename, GLuint& textureID, const TextureManager::Image* decoded = nullptr);
+    static void buildLevelGeometry();
+    // Выбирается до initialize: для CORE окну нужен контекст OpenGL 3.3
+    static RenderBackend getBackend() { return backend; }
+    static void setBackend(RenderBackend mode) { backend = mode; }
+    static ShadowMode getShadowMode() { return shadowMode; }
+    static void setShadowMode(ShadowMode mode) { shadowMode = mode; }
+    static WallRendering getWallRendering() { return wallRendering; }
+    static void setWallRendering(WallRendering mode) { wallRendering = mode; }
+    // Стены уровня сдвинулись без изменения их числа: при INSTANCED перезаписывается только
+    // буфер экземпляров (и границы кластеров), иначе геометрия строится заново
+    static void updateWallInstances();
+    // Отсечение перекрытых кластеров стен аппаратными запросами видимости (по умолчанию выключено)
+    static bool getOcclusionCulling() { return occlusionCulling; }
+    static void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
     static void drawScene(bool showMiniMap);
     static void drawMenu();
     static void drawWinScreen(int activeMessage);
+    static void drawLoadingScreen(float progress);
     static void reshape(int w, int h, GameState state);
+    // Кнопка карты WAD в меню (в пикселях, начало координат снизу слева)
+    static void getMapButtonRect(int index, float& x, float& y, float& w, float& h);
+
+    // Статистика последнего кадра: стены, отправленные на отрисовку и отброшенные отсечением
+    static int getDrawnWallCount() { return drawnWallCount; }
+    static int getCulledWallCount() { return culledWallCount; }
+    // Кластеры, пропущенные по запросам видимости как целиком перекрытые. С условной отрисовкой
+    // решает GPU, и число становится известно кадром позже - по готовым результатам запросов
+    static int getOccludedClusterCount() { return occludedClusterCount; }
 
     static GLuint wallTexture;
     static GLuint floorTexture;
     static GLfloat lightPos[];
+    static GLfloat lightDiffuse[];
+    static GLfloat ambientLight[];  // Фоновое освещение сцены (GL_LIGHT_MODEL_AMBIENT)
+    static GLfloat fogColor[];
+    static const float fogStart;
+    static const float fogEnd;
 
 private:
+    friend class CoreRenderer;
+
+    // Вершина в формате GL_T2F_N3F_V3F
+    struct WallVertex {
+        GLfloat u, v;
+        GLfloat nx, ny, nz;
+        GLfloat x, y, z;
+    };
+
+    // Вершина единичного бокса: v - доля высоты, uAxis выбирает мировую координату для u (0 - x, 1 - z)
+    struct UnitBoxVertex {
+        GLfloat v, uAxis;
+        GLfloat nx, ny, nz;
+        GLfloat x, y, z;
+    };
+
+    // Кластер - стены из одной ячейки сетки видимости уровня; их индексы (или экземпляры) лежат в буфере подряд
+    struct WallCluster {
+        float minX, minZ, maxX, maxZ;
+        GLsizei firstIndex, indexCount;
+        int firstWall, wallCount;
+        GLuint query;       // Запрос видимости, 0 - ещё не создан
+        int queryFrame;     // Кадр (occlusionFrame), в котором запрос выдан; -1 - не выдавался
+        bool boxQuery;      // Запрос по боксу (кластер был пропущен в том кадре, если бокс не виден)
+    };
+
     static void drawText(float x, float y, const char* text);
-    static void drawWall(float x, float z, float width, float height, bool shadowPass = false);
-    static void drawShadowVolume(float x, float z, float width, float height);
+    static void appendWallFace(const WallFace& face, std::map<std::tuple<WallSide, float, float>, GLuint>& edges);
+    static void buildWallClusters();
+    static void drawWalls();
+    // Кластеры стен в пирамиде видимости (до fogEnd) и в PVS ячейки камеры; матрицы по столбцам, как в GL
+    static void collectVisibleClusters(const GLfloat* projection, const GLfloat* modelview, std::vector<int>& visible,
+                                       float& eyeX, float& eyeZ);
+    static void buildWallInstancing();
+    static void drawClusterRange(int firstCluster, int lastCluster);
+    static void drawOcclusionCulled(std::vector<int>& clusters, float eyeX, float eyeZ);
+    static void drawClusterWithQuery(int index);
+    static void drawClusterBox(const WallCluster& cluster);
+    static void buildShadowVolumes();
+    static void drawShadowVolumes();
+    // Проходы z-pass по объёмам теней из уже привязанного массива вершин
+    static void countShadowVolumes();
+    static void drawStencilShadows();
+    static void bakeFloorLightmap();
+    static void enableFloorLightmap();
+    static void disableFloorLightmap();
     static void drawExit(float x, float y, float z);
     static void drawMiniMap();
+
+    static std::vector<WallVertex> wallVertices;
+    static std::vector<GLuint> wallIndices;
+    static GLuint wallVertexBuffer;
+    static GLuint wallIndexBuffer;
+    static GLsizei wallIndexCount;
+
+    static WallRendering wallRendering;
+    static std::vector<int> instanceWalls;  // Номер стены в Maze для каждого экземпляра
+    static GLuint wallInstanceBuffer;
+    static GLuint unitBoxBuffer;
+    static GLsizei unitBoxVertexCount;
+    static ShaderProgram wallProgram;
+
+    static std::vector<WallCluster> wallClusters;
+    static std::vector<int> clusterOfCell;  // Номер кластера ячейки VisibilityGrid или -1
+    static float clusterOverhang;           // Насколько бокс кластера выходит за его ячейку
+    static int drawnWallCount, culledWallCount;
+    static bool occlusionCulling;
+    static int occludedClusterCount;
+    static int occlusionFrame;  // Номер кадра для сверки с WallCluster::queryFrame
+
+    static std::vector<GLfloat> shadowVertices;
+    static GLuint shadowVertexBuffer;
+    static GLsizei shadowVertexCount;
+    static GLsizei shadowCapVertexCount;  // Крышки объёмов в начале shadowVertices, перед боковыми гранями
+    static GLfloat shadowLightPos[3];  // Положение света, для которого построены тени
+
+    static RenderBackend backend;
+    static ShadowMode shadowMode;
+    static GLuint lightmapTexture;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "ShaderProgram.h"
+#include "GLExtensions.h"
+#include <cstdio>
+#include <vector>
+
+GLuint ShaderProgram::compile(GLenum type, const char* source) {
+    GLuint shader = GLExtensions::createShader(type);
+    GLExtensions::shaderSource(shader, 1, &source, nullptr);
+    GLExtensions::compileShader(shader);
+
+    GLint status = GL_FALSE;
+    GLExtensions::getShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        GLExtensions::getShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+        std::vector<char> log(length + 1, '\0');
+        GLExtensions::getShaderInfoLog(shader, length, nullptr, log.data());
+        printf("Ошибка компиляции %s шейдера:\n%s\n", type == GL_VERTEX_SHADER ? "вершинного" : "фрагментного", log.data());
+        GLExtensions::deleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+bool ShaderProgram::build(const char* vertexSource, const char* fragmentSource,
+                          const std::vector<std::pair<GLuint, const char*>>& attributes) {
+    release();
+    if (!GLExtensions::hasShaders()) {
+        return false;
+    }
+
+    GLuint vertexShader = compile(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, fragmentSource);
+    if (!vertexShader || !fragmentShader) {
+        if (vertexShader) {
+            GLExtensions::deleteShader(vertexShader);
+        }
+        if (fragmentShader) {
+            GLExtensions::deleteShader(fragmentShader);
+        }
+        return false;
+    }
+
+    program = GLExtensions::createProgram();
+    GLExtensions::attachShader(program, vertexShader);
+    GLExtensions::attachShader(program, fragmentShader);
+    for (const auto& attribute : attributes) {
+        GLExtensions::bindAttribLocation(program, attribute.first, attribute.second);
+    }
+    GLExtensions::linkProgram(program);
+    // Шейдеры удалятся вместе с программой
+    GLExtensions::deleteShader(vertexShader);
+    GLExtensions::deleteShader(fragmentShader);
+
+    GLint status = GL_FALSE;
+    GLExtensions::getProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+        GLint length = 0;
+        GLExtensions::getProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+        std::vector<char> log(length + 1, '\0');
+        GLExtensions::getProgramInfoLog(program, length, nullptr, log.data());
+        printf("Ошибка сборки шейдерной программы:\n%s\n", log.data());
+        release();
+        return false;
+    }
+    return true;
+}
+
+void ShaderProgram::release() {
+    if (program) {
+        GLExtensions::deleteProgram(program);
+        program = 0;
+    }
+}
+
+GLint ShaderProgram::getUniform(const char* name) const {
+    return GLExtensions::getUniformLocation(program, name);
+}
+
+void ShaderProgram::bindUniformBlock(const char* name, GLuint binding) const {
+    GLuint index = GLExtensions::getUniformBlockIndex(program, name);
+    if (index != GL_INVALID_INDEX) {
+        GLExtensions::uniformBlockBinding(program, index, binding);
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef SHADER_PROGRAM_H
+#define SHADER_PROGRAM_H
+
+#include <GL/freeglut.h>
+#include <vector>
+#include <utility>
+
+// Программа из вершинного и фрагментного шейдеров. Ошибки компиляции и сборки
+// печатаются вместе с журналом драйвера, программа при этом остаётся пустой
+class ShaderProgram {
+public:
+    ShaderProgram() : program(0) {}
+    // attributes - номера, закрепляемые за атрибутами до сборки
+    bool build(const char* vertexSource, const char* fragmentSource,
+               const std::vector<std::pair<GLuint, const char*>>& attributes = {});
+    void release();
+
+    bool isValid() const { return program != 0; }
+    GLuint getId() const { return program; }
+    GLint getUniform(const char* name) const;
+    // Закрепляет uniform-блок за точкой привязки буфера (GLSL 3.30); блока может не быть в программе
+    void bindUniformBlock(const char* name, GLuint binding) const;
+
+private:
+    static GLuint compile(GLenum type, const char* source);
+
+    GLuint program;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#include "TextureManager.h"
+#include <cstdio>
+#include "C:\LabyrinthProject\include\stb_image.h"
+
+std::unordered_map<std::string, TextureManager::Entry> TextureManager::textures;
+
+GLuint TextureManager::acquire(const std::string& filename, const Image* decoded) {
+    auto it = textures.find(filename);
+    if (it != textures.end()) {
+        it->second.refCount++;
+        return it->second.textureID;
+    }
+
+    Image image;
+    if (!decoded || decoded->filename != filename) {
+        if (!decode(filename, image)) {
+            return 0;
+        }
+        decoded = &image;
+    }
+    GLuint textureID = upload(*decoded);
+    if (textureID) {
+        textures[filename] = { textureID, 1 };
+    }
+    return textureID;
+}
+
+void TextureManager::release(GLuint textureID) {
+    if (!textureID) {
+        return;
+    }
+    for (auto it = textures.begin(); it != textures.end(); ++it) {
+        if (it->second.textureID == textureID) {
+            if (--it->second.refCount == 0) {
+                glDeleteTextures(1, &it->second.textureID);
+                textures.erase(it);
+            }
+            return;
+        }
+    }
+}
+
+bool TextureManager::decode(const std::string& filename, Image& image) {
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+    if (!pixels) {
+        printf("Не удалось загрузить текстуру: %s\n", filename.c_str());
+        return false;
+    }
+    image.filename = filename;
+    image.width = width;
+    image.height = height;
+    image.channels = channels;
+    image.pixels.assign(pixels, pixels + (size_t)width * height * channels);
+    stbi_image_free(pixels);
+    return true;
+}
+
+GLuint TextureManager::upload(const Image& image) {
+    GLint maxTextureSize;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    if (image.width > maxTextureSize || image.height > maxTextureSize) {
+        printf("Ошибка: размер текстуры %dx%d превышает максимальный %d\n", image.width, image.height, maxTextureSize);
+        return 0;
+    }
+
+    GLuint textureID;
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+
+    int channels = image.channels;
+    GLenum format = channels == 4 ? GL_RGBA : (channels == 3 ? GL_RGB : (channels == 2 ? GL_LUMINANCE_ALPHA : GL_LUMINANCE));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    gluBuild2DMipmaps(GL_TEXTURE_2D, GL_RGB, image.width, image.height, format, GL_UNSIGNED_BYTE, image.pixels.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return textureID;
+}
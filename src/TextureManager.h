@@ -0,0 +1,42 @@
+#ifndef TEXTURE_MANAGER_H
+#define TEXTURE_MANAGER_H
+
+#include <GL/freeglut.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// Кэш текстур по пути файла со счётчиком ссылок.
+// Повторный acquire того же файла не декодирует и не загружает его заново;
+// текстура удаляется из GL, когда освобождена последняя ссылка
+class TextureManager {
+public:
+    // Декодированный файл, ещё не загруженный в GL
+    struct Image {
+        std::string filename;
+        int width, height, channels;
+        std::vector<unsigned char> pixels;
+    };
+
+    // Только декодирование, без GL: можно вызывать из потока загрузки уровня
+    static bool decode(const std::string& filename, Image& image);
+    // Есть ли файл в кэше; вызывать из главного потока
+    static bool isLoaded(const std::string& filename) { return textures.count(filename) != 0; }
+
+    // 0, если загрузить не удалось. decoded - уже декодированный этот же файл, тогда в главном
+    // потоке остаётся только загрузка в GL
+    static GLuint acquire(const std::string& filename, const Image* decoded = nullptr);
+    static void release(GLuint textureID);
+
+private:
+    struct Entry {
+        GLuint textureID;
+        int refCount;
+    };
+
+    static GLuint upload(const Image& image);
+
+    static std::unordered_map<std::string, Entry> textures;
+};
+
+#endif
@@ -0,0 +1,241 @@
+#include "VisibilityGrid.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Лучи выпускаются из свободных точек с шагом originSpacing (одна точка на такой квадрат)
+const float originSpacing = 0.25f;
+const int originsPerCell = (int)(VisibilityGrid::cellSize / originSpacing);
+// Лучей не меньше этого; на дальних картах их больше, см. buildPVS
+const int minRayCount = 360;
+
+}
+
+VisibilityGrid::VisibilityGrid() : originX(0.0f), originZ(0.0f), cols(0), rows(0), words(0), range(0.0f) {}
+
+void VisibilityGrid::clear() {
+    cols = 0;
+    rows = 0;
+    words = 0;
+    wallCell.clear();
+    pvs.clear();
+}
+
+int VisibilityGrid::cellAt(float x, float z) const {
+    int col = (int)std::floor((x - originX) / cellSize);
+    int row = (int)std::floor((z - originZ) / cellSize);
+    if (col < 0 || row < 0 || col >= cols || row >= rows) {
+        return -1;
+    }
+    return row * cols + col;
+}
+
+void VisibilityGrid::build(const std::vector<float>& walls, float mapWidth, float mapHeight) {
+    clear();
+    if (walls.empty()) {
+        return;
+    }
+
+    // Границы те же, что у OccupancyGrid, поэтому квадраты точек запуска лучей совпадают с её ячейками
+    float minX = -mapWidth / 2, maxX = mapWidth / 2;
+    float minZ = -mapHeight / 2, maxZ = mapHeight / 2;
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        minX = std::min(minX, walls[i]);
+        minZ = std::min(minZ, walls[i + 1]);
+        maxX = std::max(maxX, walls[i] + walls[i + 2]);
+        maxZ = std::max(maxZ, walls[i + 1] + walls[i + 3]);
+    }
+    originX = minX;
+    originZ = minZ;
+    cols = (int)std::floor((maxX - minX) / cellSize) + 1;
+    rows = (int)std::floor((maxZ - minZ) / cellSize) + 1;
+    words = (cols * rows + 63) / 64;
+
+    wallCell.resize(walls.size() / 4);
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        int col = (int)std::floor((walls[i] + walls[i + 2] / 2 - originX) / cellSize);
+        int row = (int)std::floor((walls[i + 1] + walls[i + 3] / 2 - originZ) / cellSize);
+        wallCell[i / 4] = std::min(row, rows - 1) * cols + std::min(col, cols - 1);
+    }
+}
+
+void VisibilityGrid::buildPVS(const std::vector<float>& walls, const OccupancyGrid& occupancy, float range) {
+    pvs.clear();
+    this->range = range;
+    if (cols == 0 || occupancy.getCols() == 0) {
+        return;
+    }
+    int cellCount = cols * rows;
+    int occCols = occupancy.getCols();
+    int occRows = occupancy.getRows();
+    float occCellSize = occupancy.getCellSize();
+
+    // Для каждой ячейки карты занятости - ячейки видимости стен, которые её задевают
+    // (растеризация как в OccupancyGrid::build, списки подряд в одном массиве)
+    std::vector<int> hitStart((size_t)occCols * occRows + 1, 0);
+    auto forEachCoveredCell = [&](size_t i, auto visit) {
+        int col0 = std::max(0, occupancy.cellCol(walls[i]));
+        int col1 = std::min(occCols - 1, occupancy.cellCol(walls[i] + walls[i + 2]));
+        int row0 = std::max(0, occupancy.cellRow(walls[i + 1]));
+        int row1 = std::min(occRows - 1, occupancy.cellRow(walls[i + 1] + walls[i + 3]));
+        for (int row = row0; row <= row1; row++) {
+            for (int col = col0; col <= col1; col++) {
+                visit((size_t)row * occCols + col);
+            }
+        }
+    };
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        forEachCoveredCell(i, [&](size_t cell) { hitStart[cell + 1]++; });
+    }
+    for (size_t cell = 0; cell + 1 < hitStart.size(); cell++) {
+        hitStart[cell + 1] += hitStart[cell];
+    }
+    std::vector<int> hitCells(hitStart.back());
+    std::vector<int> fill(hitStart.begin(), hitStart.end() - 1);
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        forEachCoveredCell(i, [&](size_t cell) { hitCells[fill[cell]++] = wallCell[i / 4]; });
+    }
+
+    // Луч отмечает стены не только своей ячейки, но и восьми соседних: так соседние лучи,
+    // расходящиеся к концу не больше чем на две ячейки, не пропускают клетку между собой
+    std::vector<int> nearStart((size_t)occCols * occRows + 1, 0);
+    std::vector<int> nearCells;
+    std::vector<int> near;
+    for (int row = 0; row < occRows; row++) {
+        for (int col = 0; col < occCols; col++) {
+            near.clear();
+            for (int r = std::max(0, row - 1); r <= std::min(occRows - 1, row + 1); r++) {
+                for (int c = std::max(0, col - 1); c <= std::min(occCols - 1, col + 1); c++) {
+                    size_t cell = (size_t)r * occCols + c;
+                    near.insert(near.end(), hitCells.begin() + hitStart[cell], hitCells.begin() + hitStart[cell + 1]);
+                }
+            }
+            std::sort(near.begin(), near.end());
+            near.erase(std::unique(near.begin(), near.end()), near.end());
+            nearCells.insert(nearCells.end(), near.begin(), near.end());
+            nearStart[(size_t)row * occCols + col + 1] = (int)nearCells.size();
+        }
+    }
+
+    // Луч останавливает только ячейка, целиком лежащая в стене: занятая ячейка может быть
+    // задета стеной лишь краем, и сквозь щель тоньше ячейки видно дальше
+    std::vector<unsigned char> opaque((size_t)occCols * occRows, 0);
+    for (size_t i = 0; i < walls.size(); i += 4) {
+        int col0 = std::max(0, (int)std::ceil((walls[i] - occupancy.getOriginX()) / occCellSize));
+        int col1 = std::min(occCols, (int)std::floor((walls[i] + walls[i + 2] - occupancy.getOriginX()) / occCellSize)) - 1;
+        int row0 = std::max(0, (int)std::ceil((walls[i + 1] - occupancy.getOriginZ()) / occCellSize));
+        int row1 = std::min(occRows, (int)std::floor((walls[i + 1] + walls[i + 3] - occupancy.getOriginZ()) / occCellSize)) - 1;
+        // Стена тоньше ячейки не накрывает целиком ни одной
+        if (col1 < col0 || row1 < row0) {
+            continue;
+        }
+        for (int row = row0; row <= row1; row++) {
+            std::fill(opaque.begin() + (size_t)row * occCols + col0, opaque.begin() + (size_t)row * occCols + col1 + 1, 1);
+        }
+    }
+
+    // Точки запуска: в каждом квадрате originSpacing - свободная ячейка, ближайшая к его центру
+    int originCols = cols * originsPerCell;
+    int originRows = rows * originsPerCell;
+    std::vector<int> origin((size_t)originCols * originRows, -1);
+    std::vector<float> originDistance(origin.size(), INFINITY);
+    for (int row = 0; row < occRows; row++) {
+        for (int col = 0; col < occCols; col++) {
+            if (occupancy.isCellBlocked(col, row)) {
+                continue;
+            }
+            float x = (col + 0.5f) * occCellSize;
+            float z = (row + 0.5f) * occCellSize;
+            int originCol = (int)(x / originSpacing);
+            int originRow = (int)(z / originSpacing);
+            if (originCol >= originCols || originRow >= originRows) {
+                continue;
+            }
+            float dx = x - (originCol + 0.5f) * originSpacing;
+            float dz = z - (originRow + 0.5f) * originSpacing;
+            size_t slot = (size_t)originRow * originCols + originCol;
+            if (dx * dx + dz * dz < originDistance[slot]) {
+                originDistance[slot] = dx * dx + dz * dz;
+                origin[slot] = row * occCols + col;
+            }
+        }
+    }
+
+    // Камера может стоять в стороне от точки запуска на полдиагонали квадрата
+    float maxT = (range + originSpacing * 0.70711f) / occCellSize;
+    // Шаг по углу такой, что на конце луча (maxT ячеек) соседние лучи расходятся не больше чем
+    // на две ячейки - промежуток между ними накрывают соседи, отмеченные каждым лучом
+    int rayCount = std::max(minRayCount, (int)std::ceil(M_PI * maxT));
+    std::vector<float> rayX(rayCount), rayZ(rayCount);
+    for (int ray = 0; ray < rayCount; ray++) {
+        double angle = 2.0 * M_PI * (ray + 0.5) / rayCount;
+        rayX[ray] = (float)std::cos(angle);
+        rayZ[ray] = (float)std::sin(angle);
+    }
+
+    pvs.assign((size_t)cellCount * words, 0);
+    parallelBands(cellCount, parallelBandCount(cellCount), [&](int, int begin, int end) {
+        for (int cell = begin; cell < end; cell++) {
+            uint64_t* visible = pvs.data() + (size_t)cell * words;
+            auto mark = [&](int target) { visible[target / 64] |= 1ull << (target % 64); };
+            int cellCol = cell % cols, cellRow = cell / cols;
+
+            // Соседей видно всегда: камера у края ячейки заглядывает в них мимо точек запуска
+            for (int row = std::max(0, cellRow - 1); row <= std::min(rows - 1, cellRow + 1); row++) {
+                for (int col = std::max(0, cellCol - 1); col <= std::min(cols - 1, cellCol + 1); col++) {
+                    mark(row * cols + col);
+                }
+            }
+
+            bool hasOrigin = false;
+            for (int originRow = cellRow * originsPerCell; originRow < (cellRow + 1) * originsPerCell; originRow++) {
+                for (int originCol = cellCol * originsPerCell; originCol < (cellCol + 1) * originsPerCell; originCol++) {
+                    int start = origin[(size_t)originRow * originCols + originCol];
+                    if (start < 0) {
+                        continue;
+                    }
+                    hasOrigin = true;
+
+                    // Проход луча по ячейкам карты (Amanatides-Woo) до первой непрозрачной
+                    for (int ray = 0; ray < rayCount; ray++) {
+                        int col = start % occCols, row = start / occCols;
+                        int stepX = rayX[ray] > 0.0f ? 1 : -1;
+                        int stepZ = rayZ[ray] > 0.0f ? 1 : -1;
+                        float deltaX = std::fabs(1.0f / rayX[ray]);
+                        float deltaZ = std::fabs(1.0f / rayZ[ray]);
+                        float nextX = deltaX * 0.5f, nextZ = deltaZ * 0.5f;
+                        while (true) {
+                            float t;
+                            if (nextX < nextZ) {
+                                t = nextX;
+                                nextX += deltaX;
+                                col += stepX;
+                            } else {
+                                t = nextZ;
+                                nextZ += deltaZ;
+                                row += stepZ;
+                            }
+                            if (t > maxT || col < 0 || row < 0 || col >= occCols || row >= occRows) {
+                                break;
+                            }
+                            size_t hit = (size_t)row * occCols + col;
+                            for (int k = nearStart[hit]; k < nearStart[hit + 1]; k++) {
+                                mark(nearCells[k]);
+                            }
+                            if (opaque[hit]) {
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+
+            // В ячейку без свободного места игрок не попадёт, но на всякий случай из неё видно всё
+            if (!hasOrigin) {
+                std::fill(visible, visible + words, ~0ull);
+            }
+        }
+    });
+}
@@ -0,0 +1,128 @@
+#include "WADFile.h"
+#include <cstdio>
+
+// Структуры для WAD-формата
+struct WADHeader {
+    char magic[4]; // "IWAD" или "PWAD"
+    int numLumps;
+    int directoryOffset;
+};
+
+struct WADDirectoryEntry {
+    int offset;
+    int size;
+    char name[8];
+};
+
+bool WADFile::open(const std::string& filename) {
+    close();
+    if (!file.open(filename)) {
+        printf("Ошибка загрузки WAD: %s\n", filename.c_str());
+        return false;
+    }
+
+    WADHeader header;
+    if (file.size() < sizeof(WADHeader)) {
+        printf("Неверный формат WAD-файла\n");
+        close();
+        return false;
+    }
+    memcpy(&header, file.data(), sizeof(WADHeader));
+    if (strncmp(header.magic, "IWAD", 4) != 0 && strncmp(header.magic, "PWAD", 4) != 0) {
+        printf("Неверный формат WAD-файла\n");
+        close();
+        return false;
+    }
+
+    size_t directoryEnd = (size_t)header.directoryOffset + (size_t)header.numLumps * sizeof(WADDirectoryEntry);
+    if (header.numLumps < 0 || header.directoryOffset < 0 || directoryEnd > file.size()) {
+        printf("Повреждённая директория WAD-файла\n");
+        close();
+        return false;
+    }
+
+    lumps.resize(header.numLumps);
+    lumpIndex.reserve(header.numLumps);
+    const unsigned char* directory = file.data() + header.directoryOffset;
+    for (int i = 0; i < header.numLumps; i++) {
+        WADDirectoryEntry entry;
+        memcpy(&entry, directory + i * sizeof(WADDirectoryEntry), sizeof(WADDirectoryEntry));
+
+        char name[9] = {0};
+        strncpy(name, entry.name, 8);
+        lumps[i].name = name;
+        if (entry.offset < 0 || entry.size < 0 || (size_t)entry.offset + (size_t)entry.size > file.size()) {
+            printf("Ламп %s выходит за пределы файла, пропущен\n", name);
+            lumps[i].data = nullptr;
+            lumps[i].size = 0;
+        } else {
+            lumps[i].data = file.data() + entry.offset;
+            lumps[i].size = entry.size;
+        }
+        lumpIndex[lumps[i].name].push_back(i);
+    }
+
+    this->filename = filename;
+    indexMaps();
+    return true;
+}
+
+void WADFile::indexMaps() {
+    // Лампы, которые могут идти за маркером карты
+    static const char* mapLumpNames[] = {
+        "THINGS", "LINEDEFS", "SIDEDEFS", "VERTEXES", "SEGS", "SSECTORS",
+        "NODES", "SECTORS", "REJECT", "BLOCKMAP", "BEHAVIOR", "SCRIPTS"
+    };
+    auto isMapLump = [](const std::string& name) {
+        for (const char* mapLump : mapLumpNames) {
+            if (name == mapLump) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Маркер карты - любой ламп, за которым сразу идёт THINGS; содержимое лампов не читается
+    for (size_t i = 0; i + 1 < lumps.size(); i++) {
+        if (lumps[i + 1].name != "THINGS" || isMapLump(lumps[i].name)) {
+            continue;
+        }
+        MapEntry map = { lumps[i].name, (int)i, -1, -1, -1 };
+        size_t j = i + 1;
+        for (; j < lumps.size() && isMapLump(lumps[j].name); j++) {
+            if (lumps[j].name == "THINGS") {
+                map.things = (int)j;
+            } else if (lumps[j].name == "LINEDEFS") {
+                map.linedefs = (int)j;
+            } else if (lumps[j].name == "VERTEXES") {
+                map.vertexes = (int)j;
+            }
+        }
+        maps.push_back(map);
+        i = j - 1;
+    }
+}
+
+void WADFile::close() {
+    file.close();
+    filename.clear();
+    lumps.clear();
+    lumpIndex.clear();
+    maps.clear();
+}
+
+const std::vector<int>& WADFile::findLumps(const std::string& name) const {
+    static const std::vector<int> none;
+    auto it = lumpIndex.find(name);
+    return it != lumpIndex.end() ? it->second : none;
+}
+
+
+const WADFile::MapEntry* WADFile::findMap(const std::string& name) const {
+    for (const MapEntry& map : maps) {
+        if (map.name == name) {
+            return &map;
+        }
+    }
+    return nullptr;
+}
\ No newline at end of file
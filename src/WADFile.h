@@ -0,0 +1,109 @@
+#ifndef WAD_FILE_H
+#define WAD_FILE_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstring>
+#include <cstddef>
+#include "MappedFile.h"
+
+// Записи лампов карты
+struct WADVertex {
+    short x, y;
+};
+
+struct WADLineDef {
+    short startVertex;
+    short endVertex;
+    short flags;
+    short specialType;
+    short sectorTag;
+    short rightSideDef;
+    short leftSideDef;
+};
+
+struct WADThing {
+    short x, y;
+    short angle;
+    short type;
+    short flags;
+};
+
+// Массив записей T прямо поверх отображённого файла, без копирования.
+// Смещения лампов не обязаны быть выровнены, поэтому записи читаются через memcpy
+template <typename T>
+class LumpSpan {
+public:
+    class Iterator {
+    public:
+        Iterator(const unsigned char* ptr) : ptr(ptr) {}
+        T operator*() const { T value; memcpy(&value, ptr, sizeof(T)); return value; }
+        Iterator& operator++() { ptr += sizeof(T); return *this; }
+        bool operator!=(const Iterator& other) const { return ptr != other.ptr; }
+    private:
+        const unsigned char* ptr;
+    };
+
+    LumpSpan() : bytes(nullptr), count(0) {}
+    LumpSpan(const unsigned char* bytes, size_t size) : bytes(bytes), count(size / sizeof(T)) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T operator[](size_t i) const { T value; memcpy(&value, bytes + i * sizeof(T), sizeof(T)); return value; }
+    Iterator begin() const { return Iterator(bytes); }
+    Iterator end() const { return Iterator(bytes + count * sizeof(T)); }
+
+private:
+    const unsigned char* bytes;
+    size_t count;
+};
+
+// WAD-файл, отображённый в память: проверенная директория и хеш-индекс лампов по имени
+class WADFile {
+public:
+    struct Lump {
+        std::string name;
+        const unsigned char* data;
+        size_t size;
+    };
+
+    // Карта: маркер (E1M1, MAP01, ...) и номера её лампов, -1 если лампа нет
+    struct MapEntry {
+        std::string name;
+        int marker;
+        int things;
+        int linedefs;
+        int vertexes;
+    };
+
+    bool open(const std::string& filename);
+    void close();
+
+    bool isOpen() const { return file.isOpen(); }
+    const std::string& getFilename() const { return filename; }
+    size_t getLumpCount() const { return lumps.size(); }
+    const Lump& getLump(size_t index) const { return lumps[index]; }
+
+    // Номера всех лампов с таким именем в порядке директории
+    const std::vector<int>& findLumps(const std::string& name) const;
+
+    const std::vector<MapEntry>& getMaps() const { return maps; }
+    const MapEntry* findMap(const std::string& name) const;
+
+    template <typename T>
+    LumpSpan<T> view(int index) const {
+        return LumpSpan<T>(lumps[index].data, lumps[index].size);
+    }
+
+private:
+    void indexMaps();
+
+    std::string filename;
+    MappedFile file;
+    std::vector<Lump> lumps;
+    std::unordered_map<std::string, std::vector<int>> lumpIndex;
+    std::vector<MapEntry> maps;
+};
+
+#endif
@@ -0,0 +1,329 @@
+#include "WallBoxes.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WALL_BOXES_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define WALL_BOXES_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+using Bounds = WallBoxes::Bounds;
+
+// Сборка (gather) восьми значений дорогая, поэтому AVX2 окупается только на длинных списках;
+// у коротких списков из сетки выгоднее SSE2
+const int avx2MinBoxes = 32;
+
+bool useAVX2(int boxCount) {
+#ifdef WALL_BOXES_AVX2
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported && boxCount >= avx2MinBoxes;
+#else
+    return false;
+#endif
+}
+
+// Скалярные версии - для хвостов пакетов и процессоров без SSE2
+
+bool containsScalar(const Bounds& b, int box, float x, float z, float extra) {
+    return x >= b.loX[box] - extra && x <= b.hiX[box] + extra && z >= b.loZ[box] - extra && z <= b.hiZ[box] + extra;
+}
+
+bool closerThanScalar(const Bounds& b, int box, float x, float z, float radius) {
+    float dx = std::max(0.0f, std::max(b.loX[box] - x, x - b.hiX[box]));
+    float dz = std::max(0.0f, std::max(b.loZ[box] - z, z - b.hiZ[box]));
+    return dx * dx + dz * dz < radius * radius;
+}
+
+float sweepScalar(const Bounds& b, int box, float x, float z, float dx, float dz, float extra) {
+    float enter = -INFINITY, exit = INFINITY;
+    auto slab = [&](float p, float d, float lo, float hi) {
+        if (d == 0.0f) {
+            return p >= lo && p <= hi;
+        }
+        float t1 = (lo - p) / d, t2 = (hi - p) / d;
+        enter = std::max(enter, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+        return true;
+    };
+    if (!slab(x, dx, b.loX[box] - extra, b.hiX[box] + extra) || !slab(z, dz, b.loZ[box] - extra, b.hiZ[box] + extra)) {
+        return 1.0f;
+    }
+    // enter < 0 - уже внутри бокса
+    return enter <= exit && enter >= 0.0f ? std::min(enter, 1.0f) : 1.0f;
+}
+
+#ifdef WALL_BOXES_SSE2
+
+inline __m128 gather4(const float* values, const int* boxes) {
+    return _mm_set_ps(values[boxes[3]], values[boxes[2]], values[boxes[1]], values[boxes[0]]);
+}
+
+// Ядра возвращают число обработанных боксов или -1, если ответ уже найден
+int containsSSE2(const Bounds& b, const int* boxes, int boxCount, float x, float z, float extra) {
+    const __m128 px = _mm_set1_ps(x), pz = _mm_set1_ps(z), grow = _mm_set1_ps(extra);
+    int i = 0;
+    for (; i + 4 <= boxCount; i += 4) {
+        __m128 inside = _mm_and_ps(
+            _mm_and_ps(_mm_cmpge_ps(px, _mm_sub_ps(gather4(b.loX, boxes + i), grow)),
+                       _mm_cmple_ps(px, _mm_add_ps(gather4(b.hiX, boxes + i), grow))),
+            _mm_and_ps(_mm_cmpge_ps(pz, _mm_sub_ps(gather4(b.loZ, boxes + i), grow)),
+                       _mm_cmple_ps(pz, _mm_add_ps(gather4(b.hiZ, boxes + i), grow))));
+        if (_mm_movemask_ps(inside)) {
+            return -1;
+        }
+    }
+    return i;
+}
+
+int closerThanSSE2(const Bounds& b, const int* boxes, int boxCount, float x, float z, float radius) {
+    const __m128 px = _mm_set1_ps(x), pz = _mm_set1_ps(z), zero = _mm_setzero_ps();
+    const __m128 radiusSquared = _mm_set1_ps(radius * radius);
+    int i = 0;
+    for (; i + 4 <= boxCount; i += 4) {
+        __m128 dx = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(gather4(b.loX, boxes + i), px), _mm_sub_ps(px, gather4(b.hiX, boxes + i))));
+        __m128 dz = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(gather4(b.loZ, boxes + i), pz), _mm_sub_ps(pz, gather4(b.hiZ, boxes + i))));
+        __m128 distanceSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz));
+        if (_mm_movemask_ps(_mm_cmplt_ps(distanceSquared, radiusSquared))) {
+            return -1;
+        }
+    }
+    return i;
+}
+
+// Минимальное время входа по пакетам из 4 боксов; обработанное число - в processed
+float sweepSSE2(const Bounds& b, const int* boxes, int boxCount, float x, float z, float dx, float dz, float extra, int& processed) {
+    const __m128 px = _mm_set1_ps(x), pz = _mm_set1_ps(z), grow = _mm_set1_ps(extra);
+    const __m128 vdx = _mm_set1_ps(dx), vdz = _mm_set1_ps(dz), zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 hitTime = one;
+    int i = 0;
+    for (; i + 4 <= boxCount; i += 4) {
+        __m128 loX = _mm_sub_ps(gather4(b.loX, boxes + i), grow), hiX = _mm_add_ps(gather4(b.hiX, boxes + i), grow);
+        __m128 loZ = _mm_sub_ps(gather4(b.loZ, boxes + i), grow), hiZ = _mm_add_ps(gather4(b.hiZ, boxes + i), grow);
+        __m128 enter = _mm_set1_ps(-INFINITY), exit = _mm_set1_ps(INFINITY);
+        __m128 valid = _mm_cmpeq_ps(zero, zero);
+        if (dx == 0.0f) {
+            valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(px, loX), _mm_cmple_ps(px, hiX)));
+        } else {
+            __m128 t1 = _mm_div_ps(_mm_sub_ps(loX, px), vdx), t2 = _mm_div_ps(_mm_sub_ps(hiX, px), vdx);
+            enter = _mm_max_ps(enter, _mm_min_ps(t1, t2));
+            exit = _mm_min_ps(exit, _mm_max_ps(t1, t2));
+        }
+        if (dz == 0.0f) {
+            valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(pz, loZ), _mm_cmple_ps(pz, hiZ)));
+        } else {
+            __m128 t1 = _mm_div_ps(_mm_sub_ps(loZ, pz), vdz), t2 = _mm_div_ps(_mm_sub_ps(hiZ, pz), vdz);
+            enter = _mm_max_ps(enter, _mm_min_ps(t1, t2));
+            exit = _mm_min_ps(exit, _mm_max_ps(t1, t2));
+        }
+        __m128 hit = _mm_and_ps(valid, _mm_and_ps(_mm_cmple_ps(enter, exit), _mm_cmpge_ps(enter, zero)));
+        hitTime = _mm_min_ps(hitTime, _mm_or_ps(_mm_and_ps(hit, enter), _mm_andnot_ps(hit, one)));
+    }
+    processed = i;
+    float times[4];
+    _mm_storeu_ps(times, hitTime);
+    return std::min(std::min(times[0], times[1]), std::min(times[2], times[3]));
+}
+
+#endif
+
+#ifdef WALL_BOXES_AVX2
+
+__attribute__((target("avx2")))
+int containsAVX2(const Bounds& b, const int* boxes, int boxCount, float x, float z, float extra) {
+    const __m256 px = _mm256_set1_ps(x), pz = _mm256_set1_ps(z), grow = _mm256_set1_ps(extra);
+    int i = 0;
+    for (; i + 8 <= boxCount; i += 8) {
+        __m256i index = _mm256_loadu_si256((const __m256i*)(boxes + i));
+        __m256 inside = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(px, _mm256_sub_ps(_mm256_i32gather_ps(b.loX, index, 4), grow), _CMP_GE_OQ),
+                          _mm256_cmp_ps(px, _mm256_add_ps(_mm256_i32gather_ps(b.hiX, index, 4), grow), _CMP_LE_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(pz, _mm256_sub_ps(_mm256_i32gather_ps(b.loZ, index, 4), grow), _CMP_GE_OQ),
+                          _mm256_cmp_ps(pz, _mm256_add_ps(_mm256_i32gather_ps(b.hiZ, index, 4), grow), _CMP_LE_OQ)));
+        if (_mm256_movemask_ps(inside)) {
+            return -1;
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+int closerThanAVX2(const Bounds& b, const int* boxes, int boxCount, float x, float z, float radius) {
+    const __m256 px = _mm256_set1_ps(x), pz = _mm256_set1_ps(z), zero = _mm256_setzero_ps();
+    const __m256 radiusSquared = _mm256_set1_ps(radius * radius);
+    int i = 0;
+    for (; i + 8 <= boxCount; i += 8) {
+        __m256i index = _mm256_loadu_si256((const __m256i*)(boxes + i));
+        __m256 dx = _mm256_max_ps(zero, _mm256_max_ps(_mm256_sub_ps(_mm256_i32gather_ps(b.loX, index, 4), px),
+                                                      _mm256_sub_ps(px, _mm256_i32gather_ps(b.hiX, index, 4))));
+        __m256 dz = _mm256_max_ps(zero, _mm256_max_ps(_mm256_sub_ps(_mm256_i32gather_ps(b.loZ, index, 4), pz),
+                                                      _mm256_sub_ps(pz, _mm256_i32gather_ps(b.hiZ, index, 4))));
+        __m256 distanceSquared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dz, dz));
+        if (_mm256_movemask_ps(_mm256_cmp_ps(distanceSquared, radiusSquared, _CMP_LT_OQ))) {
+            return -1;
+        }
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+float sweepAVX2(const Bounds& b, const int* boxes, int boxCount, float x, float z, float dx, float dz, float extra, int& processed) {
+    const __m256 px = _mm256_set1_ps(x), pz = _mm256_set1_ps(z), grow = _mm256_set1_ps(extra);
+    const __m256 vdx = _mm256_set1_ps(dx), vdz = _mm256_set1_ps(dz), zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    __m256 hitTime = one;
+    int i = 0;
+    for (; i + 8 <= boxCount; i += 8) {
+        __m256i index = _mm256_loadu_si256((const __m256i*)(boxes + i));
+        __m256 loX = _mm256_sub_ps(_mm256_i32gather_ps(b.loX, index, 4), grow);
+        __m256 hiX = _mm256_add_ps(_mm256_i32gather_ps(b.hiX, index, 4), grow);
+        __m256 loZ = _mm256_sub_ps(_mm256_i32gather_ps(b.loZ, index, 4), grow);
+        __m256 hiZ = _mm256_add_ps(_mm256_i32gather_ps(b.hiZ, index, 4), grow);
+        __m256 enter = _mm256_set1_ps(-INFINITY), exit = _mm256_set1_ps(INFINITY);
+        __m256 valid = _mm256_cmp_ps(zero, zero, _CMP_EQ_OQ);
+        if (dx == 0.0f) {
+            valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(px, loX, _CMP_GE_OQ), _mm256_cmp_ps(px, hiX, _CMP_LE_OQ)));
+        } else {
+            __m256 t1 = _mm256_div_ps(_mm256_sub_ps(loX, px), vdx), t2 = _mm256_div_ps(_mm256_sub_ps(hiX, px), vdx);
+            enter = _mm256_max_ps(enter, _mm256_min_ps(t1, t2));
+            exit = _mm256_min_ps(exit, _mm256_max_ps(t1, t2));
+        }
+        if (dz == 0.0f) {
+            valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(pz, loZ, _CMP_GE_OQ), _mm256_cmp_ps(pz, hiZ, _CMP_LE_OQ)));
+        } else {
+            __m256 t1 = _mm256_div_ps(_mm256_sub_ps(loZ, pz), vdz), t2 = _mm256_div_ps(_mm256_sub_ps(hiZ, pz), vdz);
+            enter = _mm256_max_ps(enter, _mm256_min_ps(t1, t2));
+            exit = _mm256_min_ps(exit, _mm256_max_ps(t1, t2));
+        }
+        __m256 hit = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(enter, exit, _CMP_LE_OQ), _mm256_cmp_ps(enter, zero, _CMP_GE_OQ)));
+        hitTime = _mm256_min_ps(hitTime, _mm256_blendv_ps(one, enter, hit));
+    }
+    processed = i;
+    float times[8];
+    _mm256_storeu_ps(times, hitTime);
+    return *std::min_element(times, times + 8);
+}
+
+#endif
+
+}
+
+WallBoxes::WallBoxes() : count(0), expansion(0.0f) {}
+
+void WallBoxes::clear() {
+    count = 0;
+    for (AlignedFloats* values : { &minX, &minZ, &maxX, &maxZ, &expandedMinX, &expandedMinZ, &expandedMaxX, &expandedMaxZ }) {
+        values->clear();
+    }
+}
+
+void WallBoxes::build(const std::vector<float>& walls, float expansion) {
+    clear();
+    this->expansion = expansion;
+    count = walls.size() / 4;
+    size_t padded = (count + 7) / 8 * 8;
+    for (AlignedFloats* values : { &minX, &minZ, &expandedMinX, &expandedMinZ }) {
+        values->assign(padded, INFINITY);
+    }
+    for (AlignedFloats* values : { &maxX, &maxZ, &expandedMaxX, &expandedMaxZ }) {
+        values->assign(padded, -INFINITY);
+    }
+    for (size_t box = 0; box < count; box++) {
+        const float* wall = walls.data() + box * 4;
+        minX[box] = wall[0];
+        minZ[box] = wall[1];
+        maxX[box] = wall[0] + wall[2];
+        maxZ[box] = wall[1] + wall[3];
+        expandedMinX[box] = minX[box] - expansion;
+        expandedMinZ[box] = minZ[box] - expansion;
+        expandedMaxX[box] = maxX[box] + expansion;
+        expandedMaxZ[box] = maxZ[box] + expansion;
+    }
+}
+
+WallBoxes::Bounds WallBoxes::boundsFor(float radius, float& extra) const {
+    // Для радиуса агента - готовые расширенные границы, для прочих - расширение в ядре
+    if (radius == expansion) {
+        extra = 0.0f;
+        return { expandedMinX.data(), expandedMinZ.data(), expandedMaxX.data(), expandedMaxZ.data() };
+    }
+    extra = radius;
+    return { minX.data(), minZ.data(), maxX.data(), maxZ.data() };
+}
+
+bool WallBoxes::anyContains(const int* boxes, int boxCount, float x, float z, float radius) const {
+    float extra;
+    Bounds bounds = boundsFor(radius, extra);
+    int i = 0;
+#ifdef WALL_BOXES_AVX2
+    if (useAVX2(boxCount)) {
+        i = containsAVX2(bounds, boxes, boxCount, x, z, extra);
+    }
+#endif
+#ifdef WALL_BOXES_SSE2
+    if (i >= 0) {
+        int done = containsSSE2(bounds, boxes + i, boxCount - i, x, z, extra);
+        i = done < 0 ? -1 : i + done;
+    }
+#endif
+    if (i < 0) {
+        return true;
+    }
+    for (; i < boxCount; i++) {
+        if (containsScalar(bounds, boxes[i], x, z, extra)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WallBoxes::anyCloserThan(const int* boxes, int boxCount, float x, float z, float radius) const {
+    Bounds bounds = { minX.data(), minZ.data(), maxX.data(), maxZ.data() };
+    int i = 0;
+#ifdef WALL_BOXES_AVX2
+    if (useAVX2(boxCount)) {
+        i = closerThanAVX2(bounds, boxes, boxCount, x, z, radius);
+    }
+#endif
+#ifdef WALL_BOXES_SSE2
+    if (i >= 0) {
+        int done = closerThanSSE2(bounds, boxes + i, boxCount - i, x, z, radius);
+        i = done < 0 ? -1 : i + done;
+    }
+#endif
+    if (i < 0) {
+        return true;
+    }
+    for (; i < boxCount; i++) {
+        if (closerThanScalar(bounds, boxes[i], x, z, radius)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+float WallBoxes::sweep(const int* boxes, int boxCount, float x, float z, float dx, float dz, float radius) const {
+    float extra;
+    Bounds bounds = boundsFor(radius, extra);
+    float hitTime = 1.0f;
+    int i = 0;
+#ifdef WALL_BOXES_AVX2
+    if (useAVX2(boxCount)) {
+        hitTime = sweepAVX2(bounds, boxes, boxCount, x, z, dx, dz, extra, i);
+    }
+#endif
+#ifdef WALL_BOXES_SSE2
+    int done = 0;
+    hitTime = std::min(hitTime, sweepSSE2(bounds, boxes + i, boxCount - i, x, z, dx, dz, extra, done));
+    i += done;
+#endif
+    for (; i < boxCount; i++) {
+        hitTime = std::min(hitTime, sweepScalar(bounds, boxes[i], x, z, dx, dz, extra));
+    }
+    return hitTime;
+}
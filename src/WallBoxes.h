@@ -0,0 +1,72 @@
+#ifndef WALL_BOXES_H
+#define WALL_BOXES_H
+
+#include <vector>
+#include <cstddef>
+#include <new>
+
+// Аллокатор с выравниванием под вектор AVX (32 байта)
+template <typename T, size_t Alignment>
+struct AlignedAllocator {
+    using value_type = T;
+    template <typename U> struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* pointer, size_t) {
+        ::operator delete(pointer, std::align_val_t(Alignment));
+    }
+    template <typename U> bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+};
+
+using AlignedFloats = std::vector<float, AlignedAllocator<float, 32>>;
+
+// Боксы стен в виде отдельных выровненных массивов границ (structure of arrays) и те же
+// границы, заранее расширенные на радиус агента. Пакетные проверки обрабатывают по 4 (SSE2)
+// или 8 (AVX2) боксов за инструкцию; номера боксов приходят из CollisionGrid.
+// Массивы дополнены до кратного 8 пустыми боксами (min = +inf, max = -inf)
+class WallBoxes {
+public:
+    WallBoxes();
+    // walls - (x, z, w, h) по 4 числа на бокс; expansion - радиус для расширенных границ
+    void build(const std::vector<float>& walls, float expansion);
+    void clear();
+
+    size_t size() const { return count; }
+    float getExpansion() const { return expansion; }
+    const float* getMinX() const { return minX.data(); }
+    const float* getMinZ() const { return minZ.data(); }
+    const float* getMaxX() const { return maxX.data(); }
+    const float* getMaxZ() const { return maxZ.data(); }
+
+    // Лежит ли точка в каком-либо боксе, расширенном на radius
+    bool anyContains(const int* boxes, int boxCount, float x, float z, float radius) const;
+    // Есть ли бокс ближе radius к точке
+    bool anyCloserThan(const int* boxes, int boxCount, float x, float z, float radius) const;
+    // Доля пути (dx, dz) до первого входа в бокс, расширенный на radius; 1, если касания нет.
+    // Боксы, внутри которых точка уже находится, не мешают из них выйти
+    float sweep(const int* boxes, int boxCount, float x, float z, float dx, float dz, float radius) const;
+
+    // Массивы границ, с которыми работают ядра; к ним ещё добавляется extra
+    struct Bounds {
+        const float* loX;
+        const float* loZ;
+        const float* hiX;
+        const float* hiZ;
+    };
+
+private:
+    Bounds boundsFor(float radius, float& extra) const;
+
+    size_t count;
+    float expansion;
+    AlignedFloats minX, minZ, maxX, maxZ;
+    AlignedFloats expandedMinX, expandedMinZ, expandedMaxX, expandedMaxZ;
+};
+
+#endif
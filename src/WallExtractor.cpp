@@ -0,0 +1,49 @@
+#include "WallExtractor.h"
+#include "BitRow.h"
+#include <algorithm>
+
+WallExtractor::WallExtractor(int width, bool mergeRows)
+    : width(width), words((width + 63) / 64), mergeRows(mergeRows), available(words), rowRunCount(0) {}
+
+void WallExtractor::addRow(const uint64_t* occupancy, int y) {
+    // Начало отрезка - бит стены, слева от которого не стена
+    uint64_t carry = 0;
+    for (int word = 0; word < words; word++) {
+        rowRunCount += popCount(occupancy[word] & ~(occupancy[word] << 1 | carry));
+        carry = occupancy[word] >> 63;
+        available[word] = occupancy[word];
+    }
+
+    // Продлеваем открытые прямоугольники; их отрезки не пересекаются, порядок не важен
+    nextOpen.clear();
+    for (PixelRect& rect : open) {
+        int end = rect.x + rect.width;
+        bool fullSpan = mergeRows;
+        for (int word = rect.x / 64; word <= (end - 1) / 64 && fullSpan; word++) {
+            uint64_t mask = wordMask(word, rect.x, end);
+            fullSpan = (occupancy[word] & mask) == mask;
+        }
+        if (fullSpan) {
+            rect.rows++;
+            for (int word = rect.x / 64; word <= (end - 1) / 64; word++) {
+                available[word] &= ~wordMask(word, rect.x, end);
+            }
+            nextOpen.push_back(rect);
+        } else {
+            rects.push_back(rect);
+        }
+    }
+
+    // Новые прямоугольники из незанятых пикселей стены, границы отрезков - сканированием битов
+    for (int x = findNext(available.data(), 0, width, true); x < width; ) {
+        int end = findNext(available.data(), x, width, false);
+        nextOpen.push_back({ x, y, end - x, 1 });
+        x = findNext(available.data(), end, width, true);
+    }
+    open.swap(nextOpen);
+}
+
+void WallExtractor::finish() {
+    rects.insert(rects.end(), open.begin(), open.end());
+    open.clear();
+}
@@ -0,0 +1,41 @@
+#ifndef WALL_EXTRACTOR_H
+#define WALL_EXTRACTOR_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// Прямоугольник стены в пикселях изображения
+struct PixelRect {
+    int x, y;
+    int width, rows;
+};
+
+// Потоковое выделение стен: строки изображения подаются сверху вниз, в памяти - только
+// прямоугольники, продолжающиеся на текущей строке. Жадное слияние даёт то же, что обход
+// с полной картой visited: открытый прямоугольник продлевается, если вся его ширина
+// в новой строке - стена, а из оставшихся пикселей стены начинаются новые прямоугольники
+class WallExtractor {
+public:
+    WallExtractor(int width, bool mergeRows);
+
+    // occupancy - битовая карта строки y (см. PixelClassifier); строки подаются подряд
+    void addRow(const uint64_t* occupancy, int y);
+    // Закрывает оставшиеся прямоугольники
+    void finish();
+
+    std::vector<PixelRect>& getRects() { return rects; }
+    size_t getRowRunCount() const { return rowRunCount; }
+
+private:
+    int width;
+    int words;
+    bool mergeRows;
+    std::vector<PixelRect> rects;
+    std::vector<PixelRect> open;      // Прямоугольники, дошедшие до последней строки
+    std::vector<PixelRect> nextOpen;
+    std::vector<uint64_t> available;  // Пиксели стены, ещё не занятые открытыми прямоугольниками
+    size_t rowRunCount;               // Число отрезков по строкам - боксов без слияния
+};
+
+#endif
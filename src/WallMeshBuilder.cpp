@@ -0,0 +1,137 @@
+#include "WallMeshBuilder.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Края соседних боксов считаются по разным формулам и совпадают лишь с точностью до округления
+const float epsilon = 1e-4f;
+
+bool isAlongX(WallSide side) {
+    return side == WallSide::NEG_Z || side == WallSide::POS_Z;
+}
+
+}
+
+void WallMeshBuilder::build(const std::vector<float>& walls, const CollisionGrid& grid, const VisibilityGrid* visibility) {
+    faces.clear();
+    int wallCount = (int)(walls.size() / 4);
+    if (wallCount == 0) {
+        return;
+    }
+
+    // Куски граней, не закрытые снаружи другими боксами (параллельно по стенам)
+    int bands = parallelBandCount(wallCount);
+    std::vector<std::vector<WallFace>> bandFaces(bands);
+    parallelBands(wallCount, bands, [&](int band, int begin, int end) {
+        std::vector<int> candidates;
+        std::vector<std::pair<float, float>> covered;
+        std::vector<WallFace>& pieces = bandFaces[band];
+        for (int wall = begin; wall < end; wall++) {
+            const float* box = walls.data() + (size_t)wall * 4;
+            float minX = box[0], minZ = box[1];
+            float maxX = box[0] + box[2], maxZ = box[1] + box[3];
+            int cell = visibility ? visibility->getWallCell(wall) : -1;
+            candidates.clear();
+            grid.collect(minX - epsilon, minZ - epsilon, maxX + epsilon, maxZ + epsilon, candidates);
+
+            for (WallSide side : { WallSide::NEG_Z, WallSide::POS_Z, WallSide::NEG_X, WallSide::POS_X }) {
+                bool alongX = isAlongX(side);
+                bool outwardNegative = side == WallSide::NEG_Z || side == WallSide::NEG_X;
+                float plane = side == WallSide::NEG_Z ? minZ : side == WallSide::POS_Z ? maxZ : side == WallSide::NEG_X ? minX : maxX;
+                float spanBegin = alongX ? minX : minZ;
+                float spanEnd = alongX ? maxX : maxZ;
+
+                // Бокс закрывает грань, если выходит за её плоскость наружу и не отстоит от неё внутрь.
+                // Боксы с той же плоскостью и стороной сюда не попадают - их разбирает второй проход
+                covered.clear();
+                for (int other : candidates) {
+                    if (other == wall) {
+                        continue;
+                    }
+                    const float* o = walls.data() + (size_t)other * 4;
+                    float depthMin = alongX ? o[1] : o[0];
+                    float depthMax = depthMin + (alongX ? o[3] : o[2]);
+                    float coverBegin = alongX ? o[0] : o[1];
+                    float coverEnd = coverBegin + (alongX ? o[2] : o[3]);
+                    bool covers = outwardNegative ? depthMin < plane - epsilon && depthMax >= plane - epsilon
+                                                  : depthMax > plane + epsilon && depthMin <= plane + epsilon;
+                    if (covers && coverBegin < spanEnd - epsilon && coverEnd > spanBegin + epsilon) {
+                        covered.push_back({ coverBegin, coverEnd });
+                    }
+                }
+                std::sort(covered.begin(), covered.end());
+
+                float position = spanBegin;
+                for (const auto& span : covered) {
+                    if (span.first > position + epsilon) {
+                        pieces.push_back({ side, plane, position, span.first, cell });
+                    }
+                    position = std::max(position, span.second);
+                }
+                if (spanEnd > position + epsilon) {
+                    pieces.push_back({ side, plane, position, spanEnd, cell });
+                }
+            }
+        }
+    });
+
+    std::vector<WallFace> pieces;
+    for (std::vector<WallFace>& band : bandFaces) {
+        pieces.insert(pieces.end(), band.begin(), band.end());
+    }
+
+    // Совпадающие грани: плоскости, отличающиеся на округление, сводятся к одной,
+    // и каждый участок плоскости достаётся куску, который начинается раньше
+    std::sort(pieces.begin(), pieces.end(), [](const WallFace& a, const WallFace& b) {
+        return a.side != b.side ? a.side < b.side : a.plane < b.plane;
+    });
+    std::vector<WallFace> visible;
+    visible.reserve(pieces.size());
+    size_t group = 0;
+    while (group < pieces.size()) {
+        size_t groupEnd = group + 1;
+        while (groupEnd < pieces.size() && pieces[groupEnd].side == pieces[group].side
+               && pieces[groupEnd].plane - pieces[groupEnd - 1].plane <= epsilon) {
+            groupEnd++;
+        }
+        std::sort(pieces.begin() + group, pieces.begin() + groupEnd, [](const WallFace& a, const WallFace& b) {
+            return a.begin < b.begin;
+        });
+        float coveredEnd = -INFINITY;
+        for (size_t i = group; i < groupEnd; i++) {
+            WallFace piece = pieces[i];
+            piece.plane = pieces[group].plane;
+            // Стык с предыдущим куском выравнивается точно: у соседних граней будут общие вершины
+            piece.begin = piece.begin - coveredEnd <= epsilon ? coveredEnd : piece.begin;
+            if (piece.end > piece.begin + epsilon) {
+                visible.push_back(piece);
+            }
+            coveredEnd = std::max(coveredEnd, pieces[i].end);
+        }
+        group = groupEnd;
+    }
+
+    // Слияние соседних кусков одной плоскости (и одной ячейки)
+    std::sort(visible.begin(), visible.end(), [](const WallFace& a, const WallFace& b) {
+        if (a.cell != b.cell) {
+            return a.cell < b.cell;
+        }
+        if (a.side != b.side) {
+            return a.side < b.side;
+        }
+        return a.plane != b.plane ? a.plane < b.plane : a.begin < b.begin;
+    });
+    for (const WallFace& piece : visible) {
+        if (!faces.empty()) {
+            WallFace& last = faces.back();
+            if (last.cell == piece.cell && last.side == piece.side && last.plane == piece.plane && piece.begin <= last.end) {
+                last.end = std::max(last.end, piece.end);
+                continue;
+            }
+        }
+        faces.push_back(piece);
+    }
+}
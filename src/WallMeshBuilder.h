@@ -0,0 +1,38 @@
+#ifndef WALL_MESH_BUILDER_H
+#define WALL_MESH_BUILDER_H
+
+#include <vector>
+#include <cstddef>
+#include "CollisionGrid.h"
+#include "VisibilityGrid.h"
+
+// Сторона бокса, наружу от которой смотрит грань
+enum class WallSide { NEG_Z, POS_Z, NEG_X, POS_X };
+
+// Боковая грань на всю высоту стен (y от -1 до 1): в плоскости plane (z для граней ±Z, x для ±X)
+// от begin до end по другой оси
+struct WallFace {
+    WallSide side;
+    float plane;
+    float begin, end;
+    int cell;  // Ячейка VisibilityGrid стены-владельца или -1
+};
+
+// Внешняя оболочка стен из пересекающихся и соприкасающихся боксов. Камера всегда между полом
+// и верхом стен (y = 0), поэтому верхние и нижние грани не строятся вовсе. От боковых граней
+// отрезаются части, закрытые снаружи другим боксом; из совпадающих граней остаётся одна;
+// соседние куски одной плоскости сливаются в одну грань. Если задана сетка видимости,
+// грани сливаются только в пределах ячейки, чтобы кластеры рендерера остались прежними
+class WallMeshBuilder {
+public:
+    // Боксы-соседи ищутся по grid; visibility может быть nullptr
+    void build(const std::vector<float>& walls, const CollisionGrid& grid, const VisibilityGrid* visibility);
+
+    // Грани по возрастанию ячейки
+    const std::vector<WallFace>& getFaces() const { return faces; }
+
+private:
+    std::vector<WallFace> faces;
+};
+
+#endif
@@ -0,0 +1,135 @@
+// Регрессионные проверки PNGRowReader на повреждённых файлах. Сборка из корня репозитория:
+//   g++ -std=c++17 -Isrc tests/PNGRowReaderTest.cpp src/PNGRowReader.cpp -o png_reader_test && ./png_reader_test
+#include "PNGRowReader.h"
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+uint32_t crc32(const unsigned char* data, size_t size) {
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+void appendUInt32(std::vector<unsigned char>& out, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back((unsigned char)(value >> shift));
+    }
+}
+
+void appendChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data) {
+    appendUInt32(out, (uint32_t)data.size());
+    size_t typeStart = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendUInt32(out, crc32(out.data() + typeStart, out.size() - typeStart));
+}
+
+// RGB 8 бит, width x height; IDAT - поток zlib из одного несжатого блока с заявленной длиной storedLength
+std::vector<unsigned char> makePNG(int width, int height, const std::vector<unsigned char>& rows, size_t storedLength) {
+    std::vector<unsigned char> png = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+    std::vector<unsigned char> header;
+    appendUInt32(header, (uint32_t)width);
+    appendUInt32(header, (uint32_t)height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });
+    appendChunk(png, "IHDR", header);
+
+    std::vector<unsigned char> zlib = { 0x78, 0x01, 0x01 };  // Последний блок, тип 0
+    zlib.push_back((unsigned char)(storedLength & 0xff));
+    zlib.push_back((unsigned char)(storedLength >> 8));
+    zlib.push_back((unsigned char)(~storedLength & 0xff));
+    zlib.push_back((unsigned char)((~storedLength >> 8) & 0xff));
+    zlib.insert(zlib.end(), rows.begin(), rows.end());
+    appendUInt32(zlib, 0);  // Adler-32 читателем не проверяется
+    appendChunk(png, "IDAT", zlib);
+    appendChunk(png, "IEND", {});
+    return png;
+}
+
+// Строки с фильтром filter; пиксели - произвольный узор
+std::vector<unsigned char> makeRows(int width, int height, unsigned char filter) {
+    std::vector<unsigned char> rows;
+    for (int y = 0; y < height; y++) {
+        rows.push_back(filter);
+        for (int x = 0; x < width * 3; x++) {
+            rows.push_back((unsigned char)(x * 7 + y * 13));
+        }
+    }
+    return rows;
+}
+
+// Пишет файл и читает его построчно; rowsRead - сколько строк отдано
+bool readPNG(const std::vector<unsigned char>& png, int& rowsRead) {
+    std::string path = "png_reader_test.png";
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    fwrite(png.data(), 1, png.size(), file);
+    fclose(file);
+
+    rowsRead = 0;
+    PNGRowReader reader;
+    bool ok = reader.open(path) && reader.readRows([&](const unsigned char*, int) { rowsRead++; });
+    remove(path.c_str());
+    return ok;
+}
+
+void testValid() {
+    std::vector<unsigned char> rows = makeRows(16, 4, 0);
+    int rowsRead = 0;
+    check(readPNG(makePNG(16, 4, rows, rows.size()), rowsRead) && rowsRead == 4, "valid stored PNG");
+}
+
+// Неверный байт фильтра: чтение должно остановиться, а не писать дальше конца строки
+void testBadFilter() {
+    std::vector<unsigned char> rows = makeRows(16, 4, 7);
+    int rowsRead = 0;
+    check(!readPNG(makePNG(16, 4, rows, rows.size()), rowsRead), "bad filter byte rejected");
+    check(rowsRead == 0, "no rows after bad filter byte");
+
+    // Ошибка во второй строке, данных в блоке на много строк больше
+    rows = makeRows(16, 64, 0);
+    rows[16 * 3 + 1] = 200;
+    check(!readPNG(makePNG(16, 4, rows, rows.size()), rowsRead), "bad filter byte in second row rejected");
+    check(rowsRead == 1, "one row before bad filter byte");
+}
+
+// Несжатый блок длиннее данных файла
+void testTruncatedStored() {
+    std::vector<unsigned char> rows = makeRows(16, 4, 0);
+    std::vector<unsigned char> png = makePNG(16, 4, rows, rows.size() + 1000);
+    int rowsRead = 0;
+    check(!readPNG(png, rowsRead), "truncated stored block rejected");
+    png.resize(png.size() / 2);
+    check(!readPNG(png, rowsRead), "truncated file rejected");
+}
+
+}
+
+int main() {
+    testValid();
+    testBadFilter();
+    testTruncatedStored();
+    if (failures == 0) {
+        printf("PNGRowReader: OK\n");
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,53 @@
+// Регрессионные проверки VisibilityGrid. Сборка из корня репозитория:
+//   g++ -std=c++17 -Isrc tests/VisibilityGridTest.cpp src/VisibilityGrid.cpp src/OccupancyGrid.cpp -o visibility_test -pthread
+#include "VisibilityGrid.h"
+#include "OccupancyGrid.h"
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+// Стена тоньше ячейки карты занятости: при заливке непрозрачных ячеек диапазон столбцов
+// получался перевёрнутым, и std::fill писал за конец буфера
+void testSubCellWall(float cellsPerUnit) {
+    std::vector<float> walls = {
+        -4.0f, -4.0f, 8.0f, 0.5f,     // Рамка поля
+        -4.0f, 3.5f, 8.0f, 0.5f,
+        -4.0f, -4.0f, 0.5f, 8.0f,
+        3.5f, -4.0f, 0.5f, 8.0f,
+        0.51f, -2.0f, 0.02f, 4.0f,    // Вертикальная стена уже ячейки
+        -2.0f, 1.03f, 4.0f, 0.01f,    // Горизонтальная
+    };
+    OccupancyGrid occupancy;
+    occupancy.build(walls, 8.0f, 8.0f, cellsPerUnit);
+    VisibilityGrid visibility;
+    visibility.build(walls, 8.0f, 8.0f);
+    visibility.buildPVS(walls, occupancy, 15.0f);
+
+    check(visibility.hasPVS(), "PVS built");
+    // Тонкая стена не непрозрачна для лучей, но сама видна из своей ячейки
+    int from = visibility.cellAt(-1.0f, -1.0f);
+    check(from >= 0 && visibility.isVisible(from, visibility.getWallCell(4)), "thin wall visible");
+    check(from >= 0 && visibility.isVisible(from, visibility.getWallCell(5)), "thin horizontal wall visible");
+}
+
+}
+
+int main() {
+    for (float cellsPerUnit : { 1.0f, 2.0f, 4.0f, 8.0f, 16.0f }) {
+        testSubCellWall(cellsPerUnit);
+    }
+    if (failures == 0) {
+        printf("VisibilityGrid: OK\n");
+    }
+    return failures == 0 ? 0 : 1;
+}